@@ -0,0 +1,44 @@
+#ifndef BIGINT_BIG_INTEGER_SERIALIZATION_H
+#define BIGINT_BIG_INTEGER_SERIALIZATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "big_integer.h"
+
+// Двоичный формат, все поля в little endian:
+//   4 байта  сигнатура "BGI" и ноль
+//   2 байта  версия формата
+//   1 байт   флаги, бит 0 -- число отрицательно
+//   1 байт   зарезервирован, ноль
+//   8 байт   количество цифр модуля n (у нуля n = 0)
+//   4n байт  цифры модуля, младшие первыми
+// Заголовок занимает 16 байт, поэтому цифры в выровненном буфере тоже выровнены.
+
+size_t serializedSize(big_integer const&);
+// пишет ровно serializedSize(a) байт
+void serialize(big_integer const&, unsigned char* out);
+std::vector<unsigned char> serialize(big_integer const&);
+// бросает std::invalid_argument, если данные не в этом формате
+big_integer deserialize(unsigned char const* in, size_t size);
+
+// Число в готовом буфере (например, в отображённом через mmap файле) без копирования цифр.
+// Буфер должен жить дольше view и не меняться.
+struct big_integer_view {
+    big_integer_view(void const* data, size_t size);
+
+    bool isNegative() const;
+    size_t size() const;
+    uint32_t digit(size_t i) const;
+    // цифры модуля прямо в буфере; nullptr, если буфер не выровнен или платформа big endian
+    uint32_t const* digits() const;
+
+    big_integer toBigInteger() const;
+
+private:
+    unsigned char const* data_;
+    size_t size_;
+    bool negative_;
+};
+
+#endif //BIGINT_BIG_INTEGER_SERIALIZATION_H
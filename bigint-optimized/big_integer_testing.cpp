@@ -2,12 +2,17 @@
 #include <cassert>
 #include <cstdlib>
 #include <random>
+#include <thread>
 #include <vector>
 #include <utility>
 #include <gtest/gtest.h>
 
 #include "big_integer.h"
 #include "big_integer_gmp.h"
+#include "digit_kernels.h"
+#include "big_integer_serialization.h"
+#include "big_integer_expr.h"
+#include "limb_pool.h"
 
 TEST(correctness, two_plus_two) {
   EXPECT_EQ(big_integer(4), big_integer(2) + big_integer(2));
@@ -76,6 +81,29 @@ TEST(correctness, assignment_return_value) {
   EXPECT_TRUE(b == 7);
 }
 
+TEST(correctness, moved_from_is_zero) {
+  // маленькие и длинные числа обоих знаков: у длинных переезжает буфер кучи
+  std::string const digits = "123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890";
+  std::vector<big_integer> values = {big_integer(-5), big_integer(7), big_integer("-" + digits), big_integer(digits)};
+  for (big_integer const& value : values) {
+    big_integer a = value;
+    big_integer b = std::move(a);
+    EXPECT_TRUE(b == value);
+    EXPECT_TRUE(a == 0);
+    EXPECT_TRUE(a.isPositive());
+    EXPECT_EQ(to_string(a), "0");
+    EXPECT_TRUE(a + 3 == 3);
+
+    big_integer c = 42;
+    c = std::move(b);
+    EXPECT_TRUE(c == value);
+    EXPECT_TRUE(b == 0);
+    EXPECT_EQ(to_string(-b), "0");
+    b = c;
+    EXPECT_TRUE(b == value);
+  }
+}
+
 TEST(correctness, comparisons) {
   big_integer a = 100;
   big_integer b = 100;
@@ -690,6 +718,160 @@ TEST(correctness, div_randomized) {
   }
 }
 
+TEST(correctness, divmod) {
+  int const values[] = {0, 7, -7, 20, -20, 3, -3};
+  for (int a : values) {
+    for (int b : values) {
+      if (b == 0) {
+        continue;
+      }
+      std::pair<big_integer, big_integer> qr = divmod(big_integer(a), big_integer(b));
+      EXPECT_EQ(qr.first, a / b);
+      EXPECT_EQ(qr.second, a % b);
+    }
+  }
+  big_integer a("-1000000000000000000000000000000000000007");
+  big_integer b("1000000000000000000001");
+  std::pair<big_integer, big_integer> qr = divmod(a, b);
+  EXPECT_EQ(qr.first, a / b);
+  EXPECT_EQ(qr.second, a % b);
+  EXPECT_EQ(qr.first * b + qr.second, a);
+}
+
+TEST(correctness, int64_boundaries) {
+  char const* values[] = {"0", "1", "-1", "4294967295", "-4294967296", "3037000499", "-3037000500",
+                          "9223372036854775807", "-9223372036854775808", "9223372036854775808",
+                          "-9223372036854775809", "18446744073709551616"};
+  for (char const* x : values) {
+    for (char const* y : values) {
+      big_integer a(x), b(y);
+      big_integer_gmp ga(x), gb(y);
+      EXPECT_EQ(to_string(ga + gb), to_string(a + b));
+      EXPECT_EQ(to_string(ga - gb), to_string(a - b));
+      EXPECT_EQ(to_string(ga * gb), to_string(a * b));
+      EXPECT_EQ(to_string(ga & gb), to_string(a & b));
+      EXPECT_EQ(to_string(ga ^ gb), to_string(a ^ b));
+      EXPECT_EQ(ga < gb, a < b);
+      EXPECT_EQ(ga == gb, a == b);
+      if (gb != 0) {
+        EXPECT_EQ(to_string(ga / gb), to_string(a / b));
+        EXPECT_EQ(to_string(ga % gb), to_string(a % b));
+      }
+    }
+    big_integer a(x);
+    big_integer_gmp ga(x);
+    EXPECT_EQ(to_string(-ga), to_string(-a));
+    EXPECT_EQ(to_string(~ga), to_string(~a));
+    EXPECT_EQ(to_string(ga << 1), to_string(a << 1));
+    EXPECT_EQ(to_string(ga << 62), to_string(a << 62));
+    EXPECT_EQ(to_string(ga >> 1), to_string(a >> 1));
+    EXPECT_EQ(to_string(ga >> 70), to_string(a >> 70));
+    EXPECT_EQ(to_string(ga), to_string(a, 10));
+    EXPECT_EQ(to_string(ga), to_string(big_integer(to_string(a, 16), 16)));
+  }
+}
+
+TEST(correctness, to_string_long_zero_runs) {
+  // нули на границах блоков при делении пополам
+  for (size_t k : {8, 9, 10, 17, 18, 19, 143, 144, 145, 1151, 1152, 1153, 5000}) {
+    std::string s = "1" + std::string(k, '0');
+    big_integer a(s);
+    EXPECT_EQ(to_string(a), s);
+    EXPECT_EQ(to_string(-a), "-" + s);
+    EXPECT_EQ(to_string(a - 1), std::string(k, '9'));
+    std::string t = s + "7" + std::string(k, '0') + "3";
+    EXPECT_EQ(to_string(big_integer(t)), t);
+  }
+}
+
+TEST(correctness, string_ctor_long) {
+  std::default_random_engine rng(11);
+  for (size_t len : {1, 9, 10, 360, 361, 1000, 4609, 20000, 80000}) {
+    std::string s(len, '0');
+    for (char& c : s) {
+      c = static_cast<char>('0' + rng() % 10);
+    }
+    s[0] = '7';
+    EXPECT_EQ(to_string(big_integer(s)), s);
+    EXPECT_EQ(to_string(big_integer("-00" + s)), "-" + s);
+  }
+  EXPECT_EQ(big_integer("-"), 0);
+  EXPECT_EQ(big_integer("+000"), 0);
+  EXPECT_THROW(big_integer(std::string(5000, '1') + "x"), std::invalid_argument);
+}
+
+TEST(correctness, radix_simple) {
+  EXPECT_EQ(to_string(big_integer(255), 16), "ff");
+  EXPECT_EQ(to_string(big_integer(-255), 2), "-11111111");
+  EXPECT_EQ(to_string(big_integer(0), 36), "0");
+  EXPECT_EQ(to_string(big_integer("-123456789012345678901234567890"), 36), "-byw97um9s91dlz68tsi");
+  EXPECT_EQ(big_integer("-FfFfFfFfFfFfFfFf", 16), big_integer("-18446744073709551615"));
+  EXPECT_EQ(big_integer("+777", 8), 511);
+  EXPECT_EQ(big_integer("zz", 36), 1295);
+  EXPECT_EQ(big_integer("-", 16), 0);
+  EXPECT_THROW(big_integer("12", 2), std::invalid_argument);
+  EXPECT_THROW(big_integer("", 16), std::invalid_argument);
+  EXPECT_THROW(big_integer("1", 37), std::invalid_argument);
+  EXPECT_THROW(to_string(big_integer(1), 1), std::invalid_argument);
+}
+
+TEST(correctness, serialization) {
+  big_integer const values[] = {big_integer(0), big_integer(1), big_integer(-1),
+                                big_integer(std::numeric_limits<int>::min()),
+                                big_integer("-18446744073709551616"),
+                                big_integer("123456789012345678901234567890123456789")};
+  for (big_integer const& a : values) {
+    std::vector<unsigned char> bytes = serialize(a);
+    EXPECT_EQ(bytes.size(), serializedSize(a));
+    EXPECT_EQ(deserialize(bytes.data(), bytes.size()), a);
+    big_integer_view view(bytes.data(), bytes.size());
+    EXPECT_EQ(view.isNegative(), a < 0);
+    EXPECT_EQ(view.toBigInteger(), a);
+  }
+
+  std::vector<unsigned char> bytes = serialize(big_integer("-18446744073709551617"));
+  ASSERT_EQ(bytes.size(), 16u + 12u);
+  EXPECT_EQ(bytes[6], 1);
+  big_integer_view view(bytes.data(), bytes.size());
+  ASSERT_EQ(view.size(), 3u);
+  EXPECT_EQ(view.digit(0), 1u);
+  EXPECT_EQ(view.digit(2), 1u);
+  ASSERT_NE(view.digits(), nullptr);
+  EXPECT_EQ(view.digits()[1], 0u);
+
+  EXPECT_THROW(deserialize(bytes.data(), bytes.size() - 1), std::invalid_argument);
+  bytes[0] = 'X';
+  EXPECT_THROW(deserialize(bytes.data(), bytes.size()), std::invalid_argument);
+  EXPECT_THROW(big_integer_view(bytes.data(), 3), std::invalid_argument);
+}
+
+namespace {
+void check_div_digit_patterns(size_t max_len, size_t iterations) {
+  // на таких цифрах оценка очередной цифры частного чаще всего ошибается
+  uint32_t const digits[] = {0, 1, 0x7FFFFFFFu, 0x80000000u, 0xFFFFFFFEu, 0xFFFFFFFFu};
+  std::default_random_engine rng(7);
+  for (size_t itn = 0; itn != iterations; ++itn) {
+    big_integer a = 0;
+    big_integer b = 1;
+    for (size_t i = 0, len = 2 + rng() % (2 * max_len); i != len; ++i) {
+      (a <<= 32) += digits[rng() % 6];
+    }
+    for (size_t i = 0, len = 1 + rng() % max_len; i != len; ++i) {
+      (b <<= 32) += digits[rng() % 6];
+    }
+    big_integer_gmp ga(to_string(a)), gb(to_string(b));
+    EXPECT_EQ(to_string(ga / gb), to_string(a / b));
+    EXPECT_EQ(to_string(ga % gb), to_string(a % b));
+    EXPECT_EQ(to_string(-ga / gb), to_string(-a / b));
+    EXPECT_EQ(to_string(ga % -gb), to_string(a % -b));
+  }
+}
+}
+
+TEST(correctness, div_digit_patterns) {
+  check_div_digit_patterns(4, number_of_multipliers);
+}
+
 // y2019 tests
 
 TEST(correctness_random, cmp) {
@@ -744,6 +926,137 @@ TEST(correctness_random, mul) {
   }
 }
 
+namespace {
+struct threshold_guard {
+  threshold_guard(size_t& threshold, size_t value) : threshold(threshold), saved(threshold) {
+    threshold = value;
+  }
+
+  ~threshold_guard() {
+    threshold = saved;
+  }
+
+  size_t& threshold;
+  size_t saved;
+};
+
+void check_random_mul(size_t size_a, size_t size_b, size_t iterations) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != iterations; ++itn) {
+    big_integer_gmp a, b;
+    a.random(size_a, rng);
+    b.random(size_b, rng);
+    big_integer_gmp c = a * b;
+    big_integer R = big_integer(to_string(a)) * big_integer(to_string(b));
+    EXPECT_EQ(to_string(c), to_string(R));
+  }
+}
+}
+
+TEST(correctness_random, mul_karatsuba) {
+  threshold_guard guard(kernel_thresholds::karatsuba, 2);
+  check_random_mul(max_size, max_size, number_of_iterations);
+  check_random_mul(4 * max_size, max_size / 3, number_of_iterations);
+  check_random_mul(100, 7 * max_size, number_of_iterations);
+}
+
+TEST(correctness_random, mul_toom3) {
+  threshold_guard karatsuba(kernel_thresholds::karatsuba, 2);
+  threshold_guard toom3(kernel_thresholds::toom3, 5);
+  check_random_mul(max_size, max_size, number_of_iterations);
+  check_random_mul(4 * max_size, max_size / 3, number_of_iterations);
+
+  threshold_guard schoolbook(kernel_thresholds::karatsuba, 16);
+  check_random_mul(4 * max_size, 4 * max_size, number_of_iterations);
+}
+
+namespace {
+// операнды ровно из digits цифр и с нулевым старшим битом, чтобы размер не зависел от представления
+void check_balanced_mul(size_t digits, size_t iterations) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != iterations; ++itn) {
+    big_integer_gmp top(1);
+    top <<= static_cast<int>(digits * DIGIT_BITS - 2);
+    big_integer_gmp a, b;
+    a.random(digits * DIGIT_BITS - 3, rng);
+    b.random(digits * DIGIT_BITS - 3, rng);
+    a += top;
+    b += top;
+    big_integer_gmp c = a * b;
+    big_integer R = big_integer(to_string(a)) * big_integer(to_string(b));
+    EXPECT_EQ(to_string(c), to_string(R));
+  }
+}
+}
+
+TEST(correctness_random, mul_toom3_default_thresholds) {
+  // у Toom-3 подпроизведения размеров k и k + 1 попадают по разные стороны порога Карацубы
+  for (size_t digits = 379; digits <= 383; ++digits) {
+    check_balanced_mul(digits, 2);
+  }
+  for (size_t digits = 1132; digits <= 1138; ++digits) {
+    check_balanced_mul(digits, 1);
+  }
+}
+
+TEST(correctness_random, mul_ntt) {
+  threshold_guard ntt(kernel_thresholds::ntt, 2);
+  check_random_mul(max_size, max_size, number_of_iterations);
+  check_random_mul(4 * max_size, max_size / 3, number_of_iterations);
+  check_random_mul(1, 2 * max_size, number_of_iterations);
+
+  threshold_guard toom3(kernel_thresholds::toom3, 5);
+  threshold_guard ntt_inside_toom3(kernel_thresholds::ntt, 20);
+  check_random_mul(4 * max_size, 4 * max_size, number_of_iterations);
+}
+
+TEST(correctness_random, mul_ntt_cutoff) {
+  // по обе стороны порога NTT: ниже него Toom-3 с подпроизведениями на Карацубе
+  threshold_guard ntt(kernel_thresholds::ntt, 200);
+  for (size_t digits = 196; digits <= 203; ++digits) {
+    check_balanced_mul(digits, 2);
+  }
+  check_random_mul(199 * DIGIT_BITS, 120 * DIGIT_BITS, number_of_iterations);
+}
+
+namespace {
+void check_random_sqr(size_t size, size_t iterations) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != iterations; ++itn) {
+    big_integer_gmp a;
+    a.random(size, rng);
+    big_integer_gmp c = a * a;
+    big_integer A = big_integer(to_string(a));
+    big_integer B = A;
+    EXPECT_EQ(to_string(c), to_string(A * A));
+    EXPECT_EQ(to_string(c), to_string(A * B));
+    A *= A;
+    EXPECT_EQ(to_string(c), to_string(A));
+  }
+}
+}
+
+TEST(correctness_random, sqr) {
+  check_random_sqr(max_size, number_of_iterations);
+  {
+    threshold_guard karatsuba(kernel_thresholds::karatsuba, 2);
+    check_random_sqr(max_size, number_of_iterations);
+  }
+  {
+    threshold_guard toom3(kernel_thresholds::toom3, 5);
+    check_random_sqr(4 * max_size, number_of_iterations);
+  }
+  {
+    threshold_guard ntt(kernel_thresholds::ntt, 2);
+    check_random_sqr(max_size, number_of_iterations);
+  }
+}
+
+TEST(correctness_random, mul_karatsuba_long) {
+  check_random_mul(8 * max_size, 8 * max_size, 2);
+  check_random_mul(8 * max_size, 3 * max_size, 2);
+}
+
 TEST(correctness_random, div) {
   std::default_random_engine rng(322);
   for (size_t itn = 0; itn != number_of_iterations; ++itn) {
@@ -760,6 +1073,198 @@ TEST(correctness_random, div) {
   }
 }
 
+TEST(correctness_random, div_burnikel_ziegler) {
+  threshold_guard guard(kernel_thresholds::burnikelZiegler, 4);
+  std::default_random_engine rng(322);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a, b;
+    a.random(4 * max_size, rng);
+    b.random(max_size + 1000 * itn % max_size, rng);
+    big_integer A = big_integer(to_string(a));
+    big_integer B = big_integer(to_string(b));
+    EXPECT_EQ(to_string(a / b), to_string(A / B));
+    EXPECT_EQ(to_string(a % b), to_string(A % B));
+  }
+  check_div_digit_patterns(40, number_of_iterations * 10);
+}
+
+TEST(correctness_random, div_newton) {
+  threshold_guard guard(kernel_thresholds::newton, 8);
+  std::default_random_engine rng(1337);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a, b;
+    a.random(4 * max_size, rng);
+    b.random(max_size + 1000 * itn % max_size, rng);
+    big_integer A = big_integer(to_string(a));
+    big_integer B = big_integer(to_string(b));
+    EXPECT_EQ(to_string(a / b), to_string(A / B));
+    EXPECT_EQ(to_string(a % b), to_string(A % B));
+  }
+  check_div_digit_patterns(40, number_of_iterations * 10);
+}
+
+TEST(correctness_random, divmod) {
+  std::default_random_engine rng(7331);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a, b;
+    a.random(2 * max_size, rng);
+    b.random(max_size / 2 + 100 * itn, rng);
+    if (itn % 2 != 0) {
+      a = -a;
+    }
+    std::pair<big_integer, big_integer> qr = divmod(big_integer(to_string(a)), big_integer(to_string(b)));
+    EXPECT_EQ(to_string(a / b), to_string(qr.first));
+    EXPECT_EQ(to_string(a % b), to_string(qr.second));
+  }
+}
+
+namespace {
+std::string gmp_to_string(big_integer_gmp a, int radix) {
+  if (a == 0) {
+    return "0";
+  }
+  bool negative = a < 0;
+  if (negative) {
+    a = -a;
+  }
+  std::string res;
+  while (a != 0) {
+    res += "0123456789abcdefghijklmnopqrstuvwxyz"[std::stoi(to_string(a % radix))];
+    a /= radix;
+  }
+  if (negative) {
+    res += '-';
+  }
+  return std::string(res.rbegin(), res.rend());
+}
+}
+
+TEST(correctness_random, radix) {
+  std::default_random_engine rng(36);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    for (int radix : {2, 3, 7, 8, 10, 16, 32, 36}) {
+      big_integer_gmp a;
+      a.random(max_size + 77 * itn, rng);
+      std::string s = gmp_to_string(a, radix);
+      big_integer A(to_string(a));
+      EXPECT_EQ(to_string(A, radix), s);
+      EXPECT_EQ(big_integer(s, radix), A);
+    }
+  }
+}
+
+TEST(correctness_random, serialization) {
+  std::default_random_engine rng(16);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a;
+    a.random(4 * max_size + 33 * itn, rng);
+    big_integer A(to_string(a));
+    std::vector<unsigned char> bytes = serialize(A);
+    EXPECT_EQ(to_string(deserialize(bytes.data(), bytes.size())), to_string(a));
+  }
+}
+
+TEST(correctness_random, lazy_expressions) {
+  std::default_random_engine rng(18);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a, b, c;
+    a.random(max_size / 8 * (itn + 1), rng);
+    b.random(max_size / 4 + 300 * itn, rng);
+    c.random(max_size, rng);
+    if (itn % 2 != 0) {
+      a = -a;
+    }
+    if (itn % 3 != 0) {
+      c = -c;
+    }
+    big_integer A(to_string(a)), B(to_string(b)), C(to_string(c));
+    unsigned shift = 40 * itn + (itn % 2 == 0 ? 0 : 7);
+
+    EXPECT_EQ(to_string(c + a * b), to_string(C + lazy(A) * B));
+    EXPECT_EQ(to_string(a * b + c), to_string(lazy(A) * B + C));
+    EXPECT_EQ(to_string(c - a * b), to_string(C - lazy(A) * B));
+    EXPECT_EQ(to_string(a * b + c * a), to_string(lazy(A) * B + lazy(C) * A));
+    EXPECT_EQ(to_string(a * b - c * c), to_string(lazy(A) * B - lazy(C) * C));
+    EXPECT_EQ(to_string(c + (a << shift)), to_string(C + (lazy(A) << shift)));
+    EXPECT_EQ(to_string(c - (a << shift)), to_string(C - (lazy(A) << shift)));
+
+    big_integer R = C;
+    R -= lazy(A) * B;
+    R += lazy(R) * A;
+    R -= lazy(R) << shift;
+    big_integer_gmp r = c - a * b;
+    r += r * a;
+    r -= r << shift;
+    EXPECT_EQ(to_string(r), to_string(R));
+  }
+}
+
+TEST(correctness_random, lazy_expressions_temporary_base) {
+  std::default_random_engine rng(19);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a, b, c;
+    a.random(max_size / 8 * (itn + 1), rng);
+    b.random(max_size / 4 + 300 * itn, rng);
+    c.random(max_size, rng);
+    if (itn % 2 != 0) {
+      a = -a;
+    }
+    big_integer A(to_string(a)), B(to_string(b)), C(to_string(c));
+    unsigned shift = 40 * itn + 3;
+
+    EXPECT_EQ(to_string((c + a) + a * b), to_string((C + A) + lazy(A) * B));
+    EXPECT_EQ(to_string(a * b + (c + a)), to_string(lazy(A) * B + (C + A)));
+    EXPECT_EQ(to_string((c + a) - a * b), to_string((C + A) - lazy(A) * B));
+    EXPECT_EQ(to_string((c + a) + (a << shift)), to_string((C + A) + (lazy(A) << shift)));
+    EXPECT_EQ(to_string((a << shift) + (c + a)), to_string((lazy(A) << shift) + (C + A)));
+    EXPECT_EQ(to_string(1 - (a << 3)), to_string(big_integer(1) - (lazy(A) << 3)));
+    EXPECT_EQ(to_string(1 - a * b), to_string(big_integer(1) - lazy(A) * B));
+  }
+}
+
+TEST(correctness_random, addmul) {
+  std::default_random_engine rng(20);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a, b, c;
+    a.random(max_size / 8 * (itn + 1), rng);
+    b.random(max_size / 4 + 300 * itn, rng);
+    c.random(max_size, rng);
+    if (itn % 2 != 0) {
+      a = -a;
+    }
+    if (itn % 3 != 0) {
+      c = -c;
+    }
+    uint32_t small32 = static_cast<uint32_t>(rng());
+    uint64_t small64 = (static_cast<uint64_t>(rng()) << 32) ^ rng();
+    big_integer A(to_string(a)), B(to_string(b)), C(to_string(c));
+
+    big_integer R = C;
+    EXPECT_EQ(to_string(c + a * b), to_string(addmul(R, A, B)));
+    EXPECT_EQ(to_string(c), to_string(submul(R, A, B)));
+    EXPECT_EQ(to_string(c + a * big_integer_gmp(std::to_string(small32))), to_string(addmul(R, A, small32)));
+    EXPECT_EQ(to_string(c), to_string(submul(R, A, small32)));
+    EXPECT_EQ(to_string(c - a * big_integer_gmp(std::to_string(small64))), to_string(submul(R, A, small64)));
+    EXPECT_EQ(to_string(c), to_string(addmul(R, A, small64)));
+    EXPECT_EQ(to_string(c), to_string(addmul(R, A, uint64_t(0))));
+    EXPECT_EQ(to_string(c - a * 7), to_string(addmul(R, A, -7)));
+    EXPECT_EQ(to_string(c), to_string(addmul(R, A, 7)));
+    EXPECT_EQ(to_string(c + a * 5), to_string(submul(R, A, -5L)));
+    EXPECT_EQ(to_string(c), to_string(submul(R, A, static_cast<short>(5))));
+    big_integer_gmp int64_min(std::to_string(INT64_MIN));
+    EXPECT_EQ(to_string(c + a * int64_min), to_string(addmul(R, A, INT64_MIN)));
+    EXPECT_EQ(to_string(c), to_string(submul(R, A, INT64_MIN)));
+
+    addmul(R, R, B);
+    submul(R, A, R);
+    addmul(R, R, 3);
+    big_integer_gmp r = c + c * b;
+    r -= a * r;
+    r += r * 3;
+    EXPECT_EQ(to_string(r), to_string(R));
+  }
+}
+
 TEST(correctness_random, mod) {
   std::default_random_engine rng(322);
   for (size_t itn = 0; itn != number_of_iterations; ++itn) {
@@ -835,3 +1340,42 @@ TEST(correctness_twos_complement, all_ones) {
 
   EXPECT_EQ(to_string(gmp_ans), to_string(your_ans));
 }
+
+TEST(limb_pool, temporaries_reuse_memory) {
+  big_integer a(std::string(500, '7'));
+  big_integer b = a * 3;
+  big_integer expected = (a + b) * a - b;
+  limb_pool::resetStats();
+  big_integer r;
+  for (int i = 0; i < 100; ++i) {
+    r = (a + b) * a - b;
+  }
+  limb_pool_stats stats = limb_pool::stats();
+  EXPECT_EQ(expected, r);
+  EXPECT_GT(stats.hits, 0u);
+  EXPECT_GT(stats.hitRate(), 0.9);
+}
+
+#ifdef BIGINT_ATOMIC_REFCOUNT
+TEST(cow, copies_shared_across_threads) {
+  big_integer a(std::string(2000, '3'));
+  std::vector<big_integer> results(8);
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t != results.size(); ++t) {
+    workers.emplace_back([&a, &results, t] {
+      for (int i = 0; i < 200; ++i) {
+        big_integer copy = a;
+        results[t] = copy;
+        copy += static_cast<int>(t);
+        results[t] = copy;
+      }
+    });
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  for (size_t t = 0; t != results.size(); ++t) {
+    EXPECT_EQ(a + static_cast<int>(t), results[t]);
+  }
+}
+#endif
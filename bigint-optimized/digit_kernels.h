@@ -0,0 +1,38 @@
+#ifndef BIGINT_DIGIT_KERNELS_H
+#define BIGINT_DIGIT_KERNELS_H
+
+#include "digit_type.h"
+
+// Работа с беззнаковыми числами в виде массивов цифр (little endian).
+// Пороги задаются в цифрах меньшего из операндов (при делении -- в цифрах делителя и частного)
+// и могут меняться во время работы.
+struct kernel_thresholds {
+    static size_t karatsuba;
+    static size_t toom3;
+    static size_t ntt;
+    static size_t burnikelZiegler;
+    static size_t newton;
+};
+
+// r[0, n + m) = a[0, n) * b[0, m), r не должен пересекаться с a и b
+// при a == b и n == m на всех уровнях используется возведение в квадрат
+void mulVectors(digit_t* r, digit_t const* a, size_t n, digit_t const* b, size_t m);
+
+// r[0, rn) += a[0, n) * b[0, m) и r[0, rn) -= a[0, n) * b[0, m) по модулю B^rn при rn >= n + m,
+// возвращают перенос (заём) из старшей цифры; при маленьком множителе произведение
+// накапливается строками прямо в r, без промежуточного массива
+digit_t addMulVectors(digit_t* r, size_t rn, digit_t const* a, size_t n, digit_t const* b, size_t m);
+digit_t subMulVectors(digit_t* r, size_t rn, digit_t const* a, size_t n, digit_t const* b, size_t m);
+
+// q[0, n - m + 1) = u[0, n) / v[0, m), r[0, m) = u[0, n) % v[0, m) (если r не nullptr)
+// требуется n >= m >= 2 и v[m - 1] != 0, выходные массивы не должны пересекаться с входными
+void divRemVectors(digit_t* q, digit_t* r, digit_t const* u, size_t n, digit_t const* v, size_t m);
+
+enum class bitwise_op { AND, OR, XOR, ASSIGN };
+
+// r[i] = r[i] op a[i] и r[i] = r[i] op value для i < n; используются самые широкие векторные
+// инструкции процессора (SSE2, AVX2 или AVX-512), выбираются при первом вызове
+void bitwiseVectors(digit_t* r, digit_t const* a, size_t n, bitwise_op op);
+void bitwiseFill(digit_t* r, size_t n, digit_t value, bitwise_op op);
+
+#endif //BIGINT_DIGIT_KERNELS_H
@@ -0,0 +1,20 @@
+#ifndef BIGINT_DIGIT_TYPE_H
+#define BIGINT_DIGIT_TYPE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Цифра big_integer и тип, вмещающий произведение двух цифр.
+// По умолчанию цифры 32-битные, с BIGINT_LIMB64 -- 64-битные (нужен unsigned __int128).
+#ifdef BIGINT_LIMB64
+typedef uint64_t digit_t;
+__extension__ typedef unsigned __int128 double_digit_t;
+#else
+typedef uint32_t digit_t;
+typedef uint64_t double_digit_t;
+#endif
+
+unsigned const DIGIT_BITS = 8 * sizeof(digit_t);
+digit_t const DIGIT_MAX = ~static_cast<digit_t>(0);
+
+#endif //BIGINT_DIGIT_TYPE_H
@@ -1,15 +1,43 @@
 #include "dynamic_buffer.h"
+#include <new>
 
-dynamic_buffer::dynamic_buffer() : ref_counter(1) {}
+dynamic_buffer::dynamic_buffer(size_t capacity) :
+        ref_counter(1),
+        capacity_(capacity) {}
 
-dynamic_buffer::dynamic_buffer(size_t size) :
-        data(size),
-        ref_counter(1) {}
+dynamic_buffer* dynamic_buffer::create(size_t capacity) {
+    size_t bytes = limb_pool::blockSize(sizeof(dynamic_buffer) + capacity * sizeof(digit_t));
+    void* memory = limb_pool::allocate(bytes);
+    return new (memory) dynamic_buffer((bytes - sizeof(dynamic_buffer)) / sizeof(digit_t));
+}
+
+// блок возвращается в пул с тем же размером, с которым был выделен в create
+static void destroy(dynamic_buffer* buffer) {
+    size_t bytes = sizeof(dynamic_buffer) + buffer->capacity() * sizeof(digit_t);
+    buffer->~dynamic_buffer();
+    limb_pool::deallocate(buffer, bytes);
+}
+
+#ifdef BIGINT_ATOMIC_REFCOUNT
+// acquire: записи владельцев, уже отпустивших буфер, видны до того, как единственный владелец изменит его на месте
+bool dynamic_buffer::unique() {
+    return ref_counter.load(std::memory_order_acquire) == 1;
+}
 
-dynamic_buffer::dynamic_buffer(std::vector<uint32_t> const& vec) :
-        data(vec),
-        ref_counter(1) {}
+// новая ссылка получается из существующей, поэтому упорядочивать нечего
+dynamic_buffer *dynamic_buffer::makeCopy() {
+    ref_counter.fetch_add(1, std::memory_order_relaxed);
+    return this;
+}
 
+// release публикует записи этого владельца, acquire перед удалением видит записи всех остальных
+void dynamic_buffer::reduceCounter() {
+    if (ref_counter.fetch_sub(1, std::memory_order_release) == 1) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        destroy(this);
+    }
+}
+#else
 bool dynamic_buffer::unique() {
     return ref_counter == 1;
 }
@@ -21,6 +49,7 @@ dynamic_buffer *dynamic_buffer::makeCopy() {
 
 void dynamic_buffer::reduceCounter() {
     if (--ref_counter == 0) {
-        delete this;
+        destroy(this);
     }
 }
+#endif
@@ -2,17 +2,18 @@
 #define BIGINT_DYNAMIC_BUFFER_H
 
 #include <cstddef>
-#include <cstdint>
-#include <vector>
-
+#ifdef BIGINT_ATOMIC_REFCOUNT
+#include <atomic>
+#endif
+#include "digit_type.h"
+#include "limb_pool.h"
+
+// Один блок из limb_pool: заголовок (счётчик ссылок и ёмкость), сразу за ним capacity() цифр.
+// Размер хранит владелец (my_opt_vector), цифры дальше размера не инициализированы.
+// С BIGINT_ATOMIC_REFCOUNT счётчик ссылок атомарный, и копии одного буфера можно использовать из разных потоков
 struct dynamic_buffer {
-    std::vector<uint32_t> data;
-
-    dynamic_buffer();
-
-    explicit dynamic_buffer(size_t size);
-
-    explicit dynamic_buffer(std::vector<uint32_t> const& vec);
+    // буфер с одной ссылкой; ёмкость не меньше capacity и добирается до размера блока пула
+    static dynamic_buffer* create(size_t capacity);
 
     dynamic_buffer(dynamic_buffer const&) = delete;
     dynamic_buffer& operator=(dynamic_buffer const&) = delete;
@@ -22,8 +23,29 @@ struct dynamic_buffer {
     dynamic_buffer* makeCopy();
 
     void reduceCounter();
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+    digit_t* data() {
+        return reinterpret_cast<digit_t*>(this + 1);
+    }
+
+    digit_t const* data() const {
+        return reinterpret_cast<digit_t const*>(this + 1);
+    }
 private:
+    explicit dynamic_buffer(size_t capacity);
+
+#ifdef BIGINT_ATOMIC_REFCOUNT
+    std::atomic<size_t> ref_counter;
+#else
     size_t ref_counter;
+#endif
+    size_t capacity_;
 };
 
+static_assert(sizeof(dynamic_buffer) % alignof(digit_t) == 0, "digits must follow the header aligned");
+
 #endif //BIGINT_DYNAMIC_BUFFER_H
@@ -0,0 +1,105 @@
+#include "limb_pool.h"
+#include <new>
+
+static unsigned const MIN_BLOCK_SHIFT = 5;
+static_assert((static_cast<size_t>(1) << MIN_BLOCK_SHIFT) == limb_pool::MIN_BLOCK_BYTES, "MIN_BLOCK_SHIFT");
+// классы 32, 64, ..., MAX_POOLED_BYTES байт
+static size_t const CLASS_COUNT = 12;
+static_assert((limb_pool::MIN_BLOCK_BYTES << (CLASS_COUNT - 1)) == limb_pool::MAX_POOLED_BYTES, "CLASS_COUNT");
+
+namespace {
+struct free_block {
+    free_block* next;
+};
+
+// состояние тривиально, поэтому доступно и во время уничтожения других thread_local объектов
+struct pool_state {
+    free_block* heads[CLASS_COUNT];
+    size_t counts[CLASS_COUNT];
+    limb_pool_stats stats;
+    bool closed;
+};
+
+thread_local pool_state pool;
+
+// при завершении потока отдаёт блоки из списков, после этого пул только передаёт вызовы operator new/delete
+struct pool_cleanup {
+    ~pool_cleanup() {
+        for (size_t i = 0; i < CLASS_COUNT; ++i) {
+            while (pool.heads[i] != nullptr) {
+                free_block* block = pool.heads[i];
+                pool.heads[i] = block->next;
+                ::operator delete(block);
+            }
+            pool.counts[i] = 0;
+        }
+        pool.stats.cached = 0;
+        pool.closed = true;
+    }
+};
+}
+
+// наименьший класс, вмещающий bytes <= MAX_POOLED_BYTES
+static size_t sizeClass(size_t bytes) {
+    if (bytes <= limb_pool::MIN_BLOCK_BYTES) {
+        return 0;
+    }
+    return 8 * sizeof(unsigned long long) - __builtin_clzll(bytes - 1) - MIN_BLOCK_SHIFT;
+}
+
+double limb_pool_stats::hitRate() const {
+    return (hits + misses == 0 ? 0 : static_cast<double>(hits) / static_cast<double>(hits + misses));
+}
+
+size_t limb_pool::blockSize(size_t bytes) {
+    return (bytes > MAX_POOLED_BYTES ? bytes : MIN_BLOCK_BYTES << sizeClass(bytes));
+}
+
+void* limb_pool::allocate(size_t bytes) {
+    if (bytes > MAX_POOLED_BYTES) {
+        ++pool.stats.misses;
+        return ::operator new(bytes);
+    }
+    size_t cls = sizeClass(bytes);
+    free_block* block = pool.heads[cls];
+    if (block != nullptr) {
+        pool.heads[cls] = block->next;
+        --pool.counts[cls];
+        --pool.stats.cached;
+        ++pool.stats.hits;
+        return block;
+    }
+    ++pool.stats.misses;
+    // блок всегда размера класса: его может освободить и закэшировать другой поток
+    return ::operator new(MIN_BLOCK_BYTES << cls);
+}
+
+void limb_pool::deallocate(void* p, size_t bytes) {
+    if (bytes > MAX_POOLED_BYTES || pool.closed) {
+        ::operator delete(p);
+        return;
+    }
+    size_t cls = sizeClass(bytes);
+    if (pool.counts[cls] == MAX_CACHED_BLOCKS) {
+        ::operator delete(p);
+        return;
+    }
+    // создаётся при первом кэшировании блока в потоке, чтобы списки освободились при его завершении
+    thread_local pool_cleanup cleanup;
+    free_block* block = static_cast<free_block*>(p);
+    block->next = pool.heads[cls];
+    pool.heads[cls] = block;
+    ++pool.counts[cls];
+    ++pool.stats.cached;
+    ++pool.stats.releases;
+}
+
+limb_pool_stats limb_pool::stats() {
+    return pool.stats;
+}
+
+void limb_pool::resetStats() {
+    pool.stats.hits = 0;
+    pool.stats.misses = 0;
+    pool.stats.releases = 0;
+}
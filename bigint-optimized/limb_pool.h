@@ -0,0 +1,35 @@
+#ifndef BIGINT_LIMB_POOL_H
+#define BIGINT_LIMB_POOL_H
+
+#include <cstddef>
+
+// Потоколокальный пул памяти для блоков dynamic_buffer.
+// Блоки до MAX_POOLED_BYTES округляются до степени двойки; освобождённый блок кладётся в список
+// своего класса, и следующее выделение того же класса берёт его оттуда, не обращаясь к operator new.
+// Блок можно освободить в другом потоке -- он попадёт в пул этого потока.
+struct limb_pool_stats {
+    size_t hits;        // выделения из списков пула
+    size_t misses;      // выделения через operator new (включая слишком большие блоки)
+    size_t releases;    // блоки, вернувшиеся в списки
+    size_t cached;      // блоков в списках сейчас
+
+    double hitRate() const;
+};
+
+struct limb_pool {
+    static const size_t MIN_BLOCK_BYTES = 32;
+    static const size_t MAX_POOLED_BYTES = 1 << 16;
+    // сколько блоков одного класса храним, остальные сразу отдаются operator delete
+    static const size_t MAX_CACHED_BLOCKS = 32;
+
+    // размер блока, который на самом деле выделит allocate(bytes)
+    static size_t blockSize(size_t bytes);
+    static void* allocate(size_t bytes);
+    static void deallocate(void* p, size_t bytes);
+
+    // статистика текущего потока
+    static limb_pool_stats stats();
+    static void resetStats();
+};
+
+#endif //BIGINT_LIMB_POOL_H
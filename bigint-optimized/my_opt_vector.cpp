@@ -14,6 +14,17 @@ my_opt_vector::my_opt_vector(my_opt_vector const &rhs) :
     }
 }
 
+my_opt_vector::my_opt_vector(my_opt_vector&& rhs) noexcept :
+        size_(rhs.size_),
+        isSmall_(rhs.isSmall_) {
+    if (rhs.isSmall_) {
+        std::copy_n(rhs.staticData_, rhs.size_, staticData_);
+    } else {
+        dynamicData_ = rhs.dynamicData_;
+    }
+    rhs.becomeZero();
+}
+
 my_opt_vector::~my_opt_vector() {
     if (!isSmall_) {
         dynamicData_->reduceCounter();
@@ -36,6 +47,23 @@ my_opt_vector &my_opt_vector::operator=(my_opt_vector const &other) {
     return *this;
 }
 
+my_opt_vector& my_opt_vector::operator=(my_opt_vector&& other) noexcept {
+    if (this != &other) {
+        if (!isSmall_) {
+            dynamicData_->reduceCounter();
+        }
+        size_ = other.size_;
+        isSmall_ = other.isSmall_;
+        if (other.isSmall_) {
+            std::copy_n(other.staticData_, size_, staticData_);
+        } else {
+            dynamicData_ = other.dynamicData_;
+        }
+        other.becomeZero();
+    }
+    return *this;
+}
+
 size_t my_opt_vector::size() const {
     return size_;
 }
@@ -45,37 +73,49 @@ void my_opt_vector::pop_back() {
     resize(size_ - 1);
 }
 
-void my_opt_vector::push_back(uint32_t elem) {
+void my_opt_vector::push_back(digit_t elem) {
     unshare();
     resize(size_ + 1);
     back() = elem;
 }
 
-uint32_t &my_opt_vector::back() {
+digit_t &my_opt_vector::back() {
     return operator[](size_ - 1);
 }
 
-uint32_t const &my_opt_vector::back() const {
+digit_t const &my_opt_vector::back() const {
     return operator[](size_ - 1);
 }
 
-uint32_t &my_opt_vector::operator[](size_t n) {
+digit_t &my_opt_vector::operator[](size_t n) {
     if (isSmall_) {
         return staticData_[n];
     } else {
         unshare();
-        return dynamicData_->data[n];
+        return dynamicData_->data()[n];
     }
 }
 
-uint32_t const &my_opt_vector::operator[](size_t n) const {
+digit_t const &my_opt_vector::operator[](size_t n) const {
     if (isSmall_) {
         return staticData_[n];
     } else {
-        return dynamicData_->data[n];
+        return dynamicData_->data()[n];
     }
 }
 
+digit_span my_opt_vector::mutableSpan() {
+    if (isSmall_) {
+        return {staticData_, size_};
+    }
+    unshare();
+    return {dynamicData_->data(), size_};
+}
+
+const_digit_span my_opt_vector::span() const {
+    return {isSmall_ ? staticData_ : dynamicData_->data(), size_};
+}
+
 void my_opt_vector::resize(size_t newSize) {
     if (isSmall_) {
         if (isSmall(newSize)) {
@@ -83,26 +123,46 @@ void my_opt_vector::resize(size_t newSize) {
                 std::fill(staticData_ + size_, staticData_ + newSize, 0u);
             }
         } else {
-            dynamic_buffer *newData = new dynamic_buffer(newSize);
-            std::copy_n(staticData_, size_, newData->data.begin());
+            dynamic_buffer *newData = dynamic_buffer::create(newSize);
+            std::copy_n(staticData_, size_, newData->data());
+            std::fill(newData->data() + size_, newData->data() + newSize, 0u);
             dynamicData_ = newData;
             isSmall_ = false;
         }
     } else {
-        unshare();
-        dynamicData_->data.resize(newSize);
+        size_t capacity = dynamicData_->capacity();
+        if (newSize > capacity) {
+            // ёмкость растёт хотя бы вдвое, чтобы цепочка push_back копировала O(n) цифр
+            reallocate(size_, std::max(newSize, 2 * capacity));
+        } else if (!dynamicData_->unique()) {
+            reallocate(std::min(size_, newSize), newSize);
+        }
+        if (newSize > size_) {
+            std::fill(dynamicData_->data() + size_, dynamicData_->data() + newSize, 0u);
+        }
     }
     size_ = newSize;
 }
 
 void my_opt_vector::unshare() {
     if (!isSmall_ && !dynamicData_->unique()) {
-        dynamic_buffer *newData = new dynamic_buffer(dynamicData_->data);
-        dynamicData_->reduceCounter();
-        dynamicData_ = newData;
+        reallocate(size_, size_);
     }
 }
 
+void my_opt_vector::reallocate(size_t count, size_t capacity) {
+    dynamic_buffer *newData = dynamic_buffer::create(capacity);
+    std::copy_n(dynamicData_->data(), count, newData->data());
+    dynamicData_->reduceCounter();
+    dynamicData_ = newData;
+}
+
+void my_opt_vector::becomeZero() {
+    size_ = 1;
+    isSmall_ = true;
+    staticData_[0] = 0;
+}
+
 bool my_opt_vector::isSmall(size_t x) {
     return x <= MAX_STATIC_SIZE;
 }
@@ -4,6 +4,7 @@
 #include <stdexcept>
 #include <memory>
 #include <algorithm>
+#include "digit_span.h"
 #include "dynamic_buffer.h"
 
 struct my_opt_vector {
@@ -11,23 +12,34 @@ struct my_opt_vector {
 
     my_opt_vector(my_opt_vector const& rhs);
 
+    // в перемещённом векторе остаётся одна нулевая цифра -- запись нуля у big_integer
+    my_opt_vector(my_opt_vector&& rhs) noexcept;
+
     ~my_opt_vector();
 
     my_opt_vector& operator=(my_opt_vector const& other);
 
+    my_opt_vector& operator=(my_opt_vector&& other) noexcept;
+
     size_t size() const;
 
     void pop_back();
 
-    void push_back(uint32_t elem);
+    void push_back(digit_t elem);
+
+    digit_t& back();
 
-    uint32_t& back();
+    digit_t const& back() const;
 
-    uint32_t const& back() const;
+    digit_t& operator[](size_t n);
 
-    uint32_t& operator[](size_t n);
+    digit_t const& operator[](size_t n) const;
 
-    uint32_t const& operator[](size_t n) const;
+    // все цифры одним куском: mutableSpan отделяет общий буфер один раз,
+    // дальше по указателю можно писать без проверок на каждой цифре
+    digit_span mutableSpan();
+
+    const_digit_span span() const;
 
     void resize(size_t newSize);
 
@@ -37,12 +49,18 @@ private:
     static constexpr size_t MAX_STATIC_SIZE = 8;
     union {
         dynamic_buffer* dynamicData_;
-        uint32_t staticData_[MAX_STATIC_SIZE];
+        digit_t staticData_[MAX_STATIC_SIZE];
     };
 
     static bool isSmall(size_t x);
 
     void unshare();
+
+    // одна нулевая цифра во встроенном буфере, буфер кучи уже передан другому вектору
+    void becomeZero();
+
+    // переносит первые count цифр в новый буфер ёмкости не меньше capacity
+    void reallocate(size_t count, size_t capacity);
 };
 
 #endif //BIGINT_MY_OPT_VECTOR_H
@@ -1,20 +1,221 @@
 #include "big_integer.h"
+#include "digit_kernels.h"
 #include <sstream>
+#include <algorithm>
+#include <cmath>
 
 big_integer::big_integer() : big_integer(0) {}
 
-big_integer::big_integer(int x) {
-    data_.push_back(x);
+#ifdef BIGINT_SIGN_MAGNITUDE
+big_integer::big_integer(int x) : negative_(false), small_(x) {}
+
+big_integer::big_integer(uint32_t x) : negative_(false), small_(x) {}
+
+big_integer::big_integer(big_integer&& other) noexcept
+        : data_(std::move(other.data_)), negative_(other.negative_), small_(other.small_) {
+    other.data_.clear();
+    other.negative_ = false;
+    other.small_ = 0;
+}
+
+big_integer& big_integer::operator=(big_integer&& other) noexcept {
+    if (this != &other) {
+        data_ = std::move(other.data_);
+        negative_ = other.negative_;
+        small_ = other.small_;
+        other.data_.clear();
+        other.negative_ = false;
+        other.small_ = 0;
+    }
+    return *this;
+}
+#else
+big_integer::big_integer(int x) : small_(x) {}
+
+big_integer::big_integer(uint32_t x) : small_(x) {}
+
+big_integer::big_integer(big_integer&& other) noexcept : data_(std::move(other.data_)), small_(other.small_) {
+    other.data_.clear();
+    other.small_ = 0;
+}
+
+big_integer& big_integer::operator=(big_integer&& other) noexcept {
+    if (this != &other) {
+        data_ = std::move(other.data_);
+        small_ = other.small_;
+        other.data_.clear();
+        other.small_ = 0;
+    }
+    return *this;
+}
+#endif
+
+static size_t const TO_STRING_BASE_SIZE = 40;
+static char const RADIX_DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+// сколько цифр занимает int64_t
+static size_t const SMALL_DIGITS = 64 / DIGIT_BITS;
+
+// при 64-битных цифрах сдвиг uint64_t на DIGIT_BITS не определён, поэтому он делается в два шага
+static uint64_t shiftOutDigit(uint64_t x) {
+    return (x >> (DIGIT_BITS / 2)) >> (DIGIT_BITS / 2);
+}
+
+static uint64_t shiftInDigit(uint64_t x, digit_t d) {
+    return ((x << (DIGIT_BITS / 2)) << (DIGIT_BITS / 2)) | d;
+}
+
+// x в цифрах, возвращает их количество без старших нулей
+static size_t toDigits(uint64_t x, digit_t* out) {
+    size_t n = 0;
+    for (; x != 0; ++n) {
+        out[n] = static_cast<digit_t>(x);
+        x = shiftOutDigit(x);
+    }
+    return n;
+}
+
+// деление маленьких чисел без деления на ноль и переполнения INT64_MIN / -1
+static bool isSmallDivisionSafe(int64_t a, int64_t b) {
+    return b != 0 && (b != -1 || a != INT64_MIN);
+}
+
+bool big_integer::isSmall() const {
+    return data_.empty();
+}
+
+size_t big_integer::smallAbsDigits(digit_t* out) const {
+    uint64_t value = static_cast<uint64_t>(small_);
+    return toDigits(small_ < 0 ? 0 - value : value, out);
+}
+
+big_integer const& big_integer::widened(big_integer const& x, big_integer& buffer) {
+    if (!x.isSmall()) {
+        return x;
+    }
+    buffer = x;
+    buffer.promote();
+    return buffer;
+}
+
+static void checkRadix(unsigned radix) {
+    if (radix < 2 || radix > 36) {
+        throw std::invalid_argument("Invalid radix");
+    }
+}
+
+static bool isPowerOfTwo(unsigned radix) {
+    return (radix & (radix - 1)) == 0;
+}
+
+// значение символа как цифры, 36 для символов, не являющихся цифрами
+static unsigned digitValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return static_cast<unsigned>(c - '0');
+    } else if (c >= 'a' && c <= 'z') {
+        return static_cast<unsigned>(c - 'a') + 10;
+    } else if (c >= 'A' && c <= 'Z') {
+        return static_cast<unsigned>(c - 'A') + 10;
+    }
+    return 36;
+}
+
+// наибольшая степень radix^digits, помещающаяся в цифру big_integer
+static digit_t radixChunk(unsigned radix, size_t& digits) {
+    double_digit_t chunk = radix;
+    for (digits = 1; chunk * radix <= DIGIT_MAX; ++digits) {
+        chunk *= radix;
+    }
+    return static_cast<digit_t>(chunk);
+}
+
+// столько степеней хранится между вызовами: старшая из них -- 2^(RADIX_POWERS_CACHED - 1) цифр,
+// более длинные размером с само преобразование и строятся каждый раз заново
+static size_t const RADIX_POWERS_CACHED = 12;
+
+// степени radixChunk^(2^k) для k < count: первые RADIX_POWERS_CACHED кэшируются между вызовами,
+// если нужно больше, все степени собираются в buffer
+static std::vector<big_integer> const& radixPowers(unsigned radix, size_t count, std::vector<big_integer>& buffer) {
+    thread_local std::vector<big_integer> powers[37];
+    std::vector<big_integer>& cache = powers[radix];
+    if (cache.empty()) {
+        size_t digits;
+        digit_t chunk = radixChunk(radix, digits);
+        // цифра может быть шире uint32_t, собираем её по 32 бита
+        big_integer power;
+        for (unsigned shift = DIGIT_BITS; shift != 0; shift -= 32) {
+            power = (power << 32) + static_cast<uint32_t>(chunk >> (shift - 32));
+        }
+        cache.push_back(power);
+    }
+    while (cache.size() < std::min(count, RADIX_POWERS_CACHED)) {
+        cache.push_back(cache.back() * cache.back());
+    }
+    if (count <= cache.size()) {
+        return cache;
+    }
+    buffer = cache;
+    while (buffer.size() < count) {
+        buffer.push_back(buffer.back() * buffer.back());
+    }
+    return buffer;
+}
+
+// разбирает len <= digits * 2^level цифр, где digits -- длина куска: половины разбираются независимо
+// и склеиваются умножением старшей на radixChunk^(2^(level - 1)), короткие строки -- по куску за раз
+big_integer big_integer::parseRadix(char const* str, size_t len, unsigned radix,
+                                    std::vector<big_integer> const& powers, size_t level) {
+    size_t digits;
+    digit_t chunk = radixChunk(radix, digits);
+    if (level == 0 || len <= digits * TO_STRING_BASE_SIZE) {
+        big_integer result;
+        result.data_.resize(len / digits + 2);
+        digit_t* out = result.mutableDigits().data;
+        size_t used = 1;
+        for (size_t i = 0, next = (len - 1) % digits + 1; i < len; next += digits) {
+            double_digit_t carry = 0;
+            for (; i < next; ++i) {
+                carry = carry * radix + digitValue(str[i]);
+            }
+            for (size_t j = 0; j < used; ++j) {
+                carry += static_cast<double_digit_t>(out[j]) * chunk;
+                out[j] = static_cast<digit_t>(carry);
+                carry >>= DIGIT_BITS;
+            }
+            if (carry != 0) {
+                out[used++] = static_cast<digit_t>(carry);
+            }
+        }
+        return result.trim();
+    }
+    size_t half = digits << (level - 1);
+    if (len <= half) {
+        return parseRadix(str, len, radix, powers, level - 1);
+    }
+    big_integer result = parseRadix(str, len - half, radix, powers, level - 1);
+    result *= powers[level - 1];
+    return result += parseRadix(str + len - half, half, radix, powers, level - 1);
 }
 
-big_integer::big_integer(uint32_t x) {
-    data_.push_back(x);
-    if (!isPositive(x)) {
-        data_.push_back(0);
+// при radix = 2^bits каждая цифра занимает ровно bits битов, их можно сразу раскладывать по data_
+big_integer big_integer::parsePowerOfTwo(char const* str, size_t len, unsigned bits) {
+    big_integer result;
+    result.data_.resize(len * bits / BIT_IN_DIGIT + 2);
+    digit_t* out = result.mutableDigits().data;
+    size_t pos = 0;
+    for (size_t i = len; i > 0; --i, pos += bits) {
+        double_digit_t value = static_cast<double_digit_t>(digitValue(str[i - 1])) << (pos % BIT_IN_DIGIT);
+        out[pos / BIT_IN_DIGIT] |= static_cast<digit_t>(value);
+        if ((value >> BIT_IN_DIGIT) != 0) {
+            out[pos / BIT_IN_DIGIT + 1] |= static_cast<digit_t>(value >> BIT_IN_DIGIT);
+        }
     }
+    return result.trim();
 }
 
-big_integer::big_integer(std::string const& str) : big_integer(0) {
+big_integer::big_integer(std::string const& str) : big_integer(str, 10) {}
+
+big_integer::big_integer(std::string const& str, unsigned radix) : big_integer(0) {
+    checkRadix(radix);
     size_t i = 0;
     bool isPositive = true;
     if (str.empty()) {
@@ -24,62 +225,181 @@ big_integer::big_integer(std::string const& str) : big_integer(0) {
         isPositive = (str[0] == '+');
         i = 1;
     }
-    for (;i < str.size(); ++i) {
-        if (str[i] < '0' || str[i] > '9')
+    for (size_t j = i; j < str.size(); ++j) {
+        if (digitValue(str[j]) >= radix) {
             throw std::invalid_argument("Invalid string");
-        (*this *= 10) += (str[i] - '0');
+        }
+    }
+    size_t len = str.size() - i;
+    if (len == 0) {
+        return;
+    }
+    if (isPowerOfTwo(radix)) {
+        *this = parsePowerOfTwo(str.data() + i, len, bitCount(radix - 1));
+    } else {
+        size_t digits;
+        radixChunk(radix, digits);
+        size_t level = 0;
+        while ((digits << level) < len) {
+            ++level;
+        }
+        std::vector<big_integer> buffer;
+        *this = parseRadix(str.data() + i, len, radix, radixPowers(radix, level, buffer), level);
     }
     if (!isPositive) {
         negateInPlace();
     }
+    demote();
+}
+
+#ifdef BIGINT_SIGN_MAGNITUDE
+// *this += (rhsNegative ? -1 : 1) * |rhs| * 2^(32 * pos)
+big_integer& big_integer::shiftedAbstractInPlace(big_integer const& value, size_t pos, bool rhsNegative) {
+    promote();
+    big_integer wide;
+    big_integer const& rhs = widened(value, wide);
+    size_t rhs_size = rhs.data_.size();
+    if (rhs_size == 1 && rhs.data_[0] == 0) {
+        return *this;
+    }
+    if (negative_ == rhsNegative) {
+        reserve(std::max(data_.size(), rhs_size + pos) + 1);
+        // при rhs == *this цифры берутся после reserve, чтобы указатели смотрели в один буфер
+        digit_span out = mutableDigits();
+        digit_t const* in = rhs.digits().data;
+        double_digit_t carry = 0;
+        for (size_t i = pos; i < out.size && (i < rhs_size + pos || carry != 0); ++i) {
+            carry += static_cast<double_digit_t>(out[i]) + (i - pos < rhs_size ? in[i - pos] : 0);
+            out[i] = static_cast<digit_t>(carry);
+            carry >>= DIGIT_BITS;
+        }
+        return trim();
+    }
+
+    size_t old_size = data_.size();
+    bool absSmaller = (old_size < rhs_size + pos);
+    reserve(rhs_size + pos);
+    digit_t* out = mutableDigits().data;
+    digit_t const* in = rhs.digits().data;
+    if (old_size == rhs_size + pos) {
+        size_t i = rhs_size;
+        while (i > 0 && out[i - 1 + pos] == in[i - 1]) {
+            --i;
+        }
+        absSmaller = (i > 0 && out[i - 1 + pos] < in[i - 1]);
+    }
+    digit_t borrow = 0;
+    if (absSmaller) {           // |rhs| * 2^(32 * pos) - |*this|
+        for (size_t i = 0; i < rhs_size + pos; ++i) {
+            double_digit_t cur = static_cast<double_digit_t>(i >= pos ? in[i - pos] : 0) -
+                           (i < old_size ? out[i] : 0) - borrow;
+            out[i] = static_cast<digit_t>(cur);
+            borrow = static_cast<digit_t>(cur >> (2 * DIGIT_BITS - 1));
+        }
+        negative_ = rhsNegative;
+    } else {                    // |*this| - |rhs| * 2^(32 * pos)
+        for (size_t i = pos; i < rhs_size + pos || borrow != 0; ++i) {
+            double_digit_t cur = static_cast<double_digit_t>(out[i]) -
+                           (i - pos < rhs_size ? in[i - pos] : 0) - borrow;
+            out[i] = static_cast<digit_t>(cur);
+            borrow = static_cast<digit_t>(cur >> (2 * DIGIT_BITS - 1));
+        }
+    }
+    return trim();
 }
 
-big_integer& big_integer::shiftedAbstractInPlace(big_integer const& rhs, size_t pos, uint32_t start,
-                                   std::function<uint32_t(uint32_t)> const& operation, bool sign) {
-    size_t new_size = std::max(data_.size(), rhs.data_.size());
+big_integer& big_integer::shiftedAddInPlace(big_integer const& rhs, size_t pos) {
+    return shiftedAbstractInPlace(rhs, pos, !rhs.isPositive());
+}
+
+big_integer& big_integer::shiftedSubInPlace(big_integer const& rhs, size_t pos) {
+    return shiftedAbstractInPlace(rhs, pos, rhs.isPositive());
+}
+#else
+// operation -- функтор над цифрой rhs, вызов инлайнится в цикл
+template <typename Operation>
+big_integer& big_integer::shiftedAbstractInPlace(big_integer const& value, size_t pos, digit_t start,
+                                                 Operation operation, bool sign) {
+    promote();
+    big_integer wide;
+    big_integer const& rhs = widened(value, wide);
+    size_t rhs_size = rhs.data_.size();
+    size_t new_size = std::max(data_.size(), rhs_size + pos);
     reserve(new_size + 1);
+    digit_t fill = operation(sign ? 0 : DIGIT_MAX);
+    digit_t* out = mutableDigits().data;
+    digit_t const* in = rhs.digits().data;
 
-    uint64_t carry_bit = start;
-    for (size_t i = pos; i < new_size + 1; ++i) {
-        carry_bit += static_cast<uint64_t>(data_[i]) + operation(rhs.getDigit(i - pos, sign));
-        data_[i] = carry_bit;
-        carry_bit >>= 32u;
+    double_digit_t carry_bit = start;
+    size_t i = pos;
+    for (; i < rhs_size + pos; ++i) {
+        carry_bit += static_cast<double_digit_t>(out[i]) + operation(in[i - pos]);
+        out[i] = static_cast<digit_t>(carry_bit);
+        carry_bit >>= DIGIT_BITS;
+    }
+    // за концом rhs прибавляется fill + перенос; если это 0 или 2^DIGIT_BITS, старшие цифры не меняются
+    for (; i < new_size + 1 && static_cast<digit_t>(carry_bit + fill) != 0; ++i) {
+        carry_bit += static_cast<double_digit_t>(out[i]) + fill;
+        out[i] = static_cast<digit_t>(carry_bit);
+        carry_bit >>= DIGIT_BITS;
     }
     return trim();
 }
 
 big_integer& big_integer::shiftedAddInPlace(big_integer const& rhs, size_t pos) {
-    return shiftedAbstractInPlace(rhs, pos, 0, [](uint32_t a) { return a; }, rhs.isPositive());
+    return shiftedAbstractInPlace(rhs, pos, 0, [](digit_t a) { return a; }, rhs.isPositive());
 }
 
 big_integer& big_integer::shiftedSubInPlace(big_integer const& rhs, size_t pos) {
-    return shiftedAbstractInPlace(rhs, pos, 1, [](uint32_t a) { return ~a; }, rhs.isPositive());
+    return shiftedAbstractInPlace(rhs, pos, 1, [](digit_t a) { return ~a; }, rhs.isPositive());
 }
 
 big_integer& big_integer::shiftedSubVectorInPlace(big_integer const& rhs, size_t pos) {
-    return shiftedAbstractInPlace(rhs, pos, 1, [](uint32_t a) { return ~a; }, true);
+    return shiftedAbstractInPlace(rhs, pos, 1, [](digit_t a) { return ~a; }, true);
 }
+#endif
 
 big_integer& big_integer::operator+=(big_integer const& rhs) {
-    return shiftedAddInPlace(rhs, 0);
+    int64_t sum;
+    if (isSmall() && rhs.isSmall() && !__builtin_add_overflow(small_, rhs.small_, &sum)) {
+        small_ = sum;
+        return *this;
+    }
+    return shiftedAddInPlace(rhs, 0).demote();
 }
 
 big_integer& big_integer::operator-=(big_integer const& rhs) {
-    return shiftedSubInPlace(rhs, 0);
+    int64_t difference;
+    if (isSmall() && rhs.isSmall() && !__builtin_sub_overflow(small_, rhs.small_, &difference)) {
+        small_ = difference;
+        return *this;
+    }
+    return shiftedSubInPlace(rhs, 0).demote();
 }
 
-big_integer& big_integer::operator*=(big_integer const& rhs) {
+big_integer& big_integer::operator*=(big_integer const& value) {
+    int64_t product;
+    if (isSmall() && value.isSmall() && !__builtin_mul_overflow(small_, value.small_, &product)) {
+        small_ = product;
+        return *this;
+    }
+    promote();
+    big_integer wide;
+    big_integer const& rhs = widened(value, wide);
     big_integer result;
+#ifdef BIGINT_SIGN_MAGNITUDE
+    result.data_.resize(data_.size() + rhs.data_.size());
+    // a *= a и копии, разделяющие буфер, дают одинаковые указатели -- это возведение в квадрат
+    const_digit_span lhs = digits();
+    const_digit_span in = rhs.digits();
+    mulVectors(result.mutableDigits().data, lhs.data, lhs.size, in.data, in.size);
+    result.negative_ = (negative_ != rhs.negative_);
+#else
     result.data_.resize(data_.size() + rhs.data_.size() + 1);
-    for (size_t i = 0; i < data_.size(); ++i) {
-        uint64_t carry_digit = 0;
-        for (size_t j = 0; j < rhs.data_.size(); ++j) {
-            carry_digit += static_cast<uint64_t>(data_[i]) * rhs.data_[j] + result.data_[i + j];
-            result.data_[i + j] = carry_digit;
-            carry_digit = (carry_digit >> 32u);
-        }
-        result.data_[i + rhs.data_.size()] += carry_digit;
-    }
+    // a *= a и копии, разделяющие буфер, дают одинаковые указатели -- это возведение в квадрат
+    const_digit_span lhs = digits();
+    const_digit_span in = rhs.digits();
+    mulVectors(result.mutableDigits().data, lhs.data, lhs.size, in.data, in.size);
     if (!rhs.isPositive()) {            // не забываем внести ПОПРАВКИ
         result.shiftedSubVectorInPlace(*this, rhs.data_.size());
     }
@@ -89,144 +409,256 @@ big_integer& big_integer::operator*=(big_integer const& rhs) {
     if (!rhs.isPositive() && !isPositive()) {
         result.shiftedAddInPlace(big_integer(1), data_.size() + rhs.data_.size());
     }
+#endif
     result.trim();
-    std::swap(*this, result);
-    return *this;
+    *this = std::move(result);
+    return demote();
 }
 
-big_integer& big_integer::divAbsLongDigitInPlace(uint32_t x) {
+digit_t big_integer::divRemAbsDigitInPlace(digit_t x) {
+    promote();
     absInPlace();
-    uint64_t carry = 0;
-    for (size_t i = data_.size(); i > 0; --i) {
-        uint64_t cur_val = data_[i - 1] + (carry << 32u);
-        data_[i - 1] = static_cast<uint32_t>(cur_val / x);
+    digit_span out = mutableDigits();
+    double_digit_t carry = 0;
+    for (size_t i = out.size; i > 0; --i) {
+        double_digit_t cur_val = out[i - 1] + (carry << DIGIT_BITS);
+        out[i - 1] = static_cast<digit_t>(cur_val / x);
         carry = cur_val % x;
     }
-    return trim();
+    trim();
+    return static_cast<digit_t>(carry);
 }
 
-big_integer& big_integer::operator/=(big_integer const& rhs) {
+// частное записывается в *this, остаток (того же знака, что и делимое) -- в remainder, если он не nullptr
+big_integer& big_integer::divRemInPlace(big_integer const& value, big_integer* remainder) {
+    promote();
+    big_integer wide;
+    big_integer const& rhs = widened(value, wide);
     bool resultPositive = (isPositive() == rhs.isPositive());
+    bool remainderPositive = isPositive();
     absInPlace();
+    big_integer negativeDivisor;
+    big_integer const* divisor = &rhs;      // при rhs == *this модуль уже взят
+    if (!rhs.isPositive()) {
+        negativeDivisor = rhs.abs();
+        divisor = &negativeDivisor;
+    }
 
-    if (rhs.data_.size() == 1 || (rhs.data_.size() == 2 && rhs.data_.back() == 0)) {
-        divAbsLongDigitInPlace(rhs.abs().data_[0]);
-        if (!resultPositive) {
-            negateInPlace();
-        }
+    size_t n = magnitudeSize();
+    size_t m = divisor->magnitudeSize();
+    big_integer rem;
+    if (m == 1) {
+        digit_t digit = divRemAbsDigitInPlace(divisor->data_[0]);
+        rem = fromAbsDigits(&digit, 1, false);
+    } else if (n < m) {
+        rem = *this;
+        data_.resize(1);
+        data_[0] = 0;
     } else {
-        big_integer divisor(rhs.abs());
         big_integer result;
-        if (*this >= divisor) {
-            uint32_t divisorBack;
-            size_t divisorSize = divisor.data_.size();
-            if (divisor.data_.back() != 0) {
-                divisorBack = divisor.data_.back();
-            } else {
-                divisorBack = divisor.data_[divisor.data_.size() - 2];
-                --divisorSize;
-            }
-            size_t shift = BIT_IN_DIGIT - bitCount(divisorBack);
-            divisor <<= shift;
-            *this <<= shift;
-            divisorBack = divisor.data_[divisor.data_.size() - 2];
-            result.reserve(data_.size() - divisorSize + 1);
-            for (size_t k = data_.size() - divisorSize + 1; k > 0; --k) {
-                uint32_t q = ((static_cast<uint64_t>(getDigit(k + divisorSize - 1)) << 32u) +
-                              getDigit(k + divisorSize - 2)) / divisorBack;
-                shiftedSubInPlace(divisor * q, k - 1);
-                while (!isPositive()) {     // works no more than 2 times
-                    shiftedAddInPlace(divisor, k - 1);
-                    --q;
-                }
-                result.data_[k - 1] = q;
-            }
-            if (!resultPositive) {
-                result.negateInPlace();
-            }
+        result.data_.resize(n - m + 2);
+        if (remainder != nullptr) {
+            rem.data_.resize(m + 1);
         }
-        std::swap(*this, result);
+        divRemVectors(result.mutableDigits().data, (remainder != nullptr ? rem.mutableDigits().data : nullptr),
+                      digits().data, n, divisor->digits().data, m);
+        *this = std::move(result);
+        rem.trim();
+    }
+    if (!resultPositive) {
+        negateInPlace();
+    }
+    if (remainder != nullptr) {
+        if (!remainderPositive) {
+            rem.negateInPlace();
+        }
+        rem.trim();
+        *remainder = std::move(rem);
     }
     return trim();
 }
 
+big_integer& big_integer::operator/=(big_integer const& rhs) {
+    if (isSmall() && rhs.isSmall() && isSmallDivisionSafe(small_, rhs.small_)) {
+        small_ /= rhs.small_;
+        return *this;
+    }
+    return divRemInPlace(rhs, nullptr).demote();
+}
+
 big_integer& big_integer::operator%=(big_integer const& rhs) {
-    return *this -= big_integer(*this) / rhs * rhs;
+    if (isSmall() && rhs.isSmall() && isSmallDivisionSafe(small_, rhs.small_)) {
+        small_ %= rhs.small_;
+        return *this;
+    }
+    big_integer quotient = *this;
+    quotient.divRemInPlace(rhs, this);
+    return demote();
 }
 
-big_integer& big_integer::bit_operation(big_integer const& rhs, const
-std::function<uint32_t(uint32_t, uint32_t)>& operation) {
-    size_t max_size = (rhs.data_.size() > data_.size() ? rhs.data_.size() : data_.size());
+// операции для bit_operation: над одной цифрой и над массивами цифр (op для bitwiseVectors)
+struct digit_and {
+    static bitwise_op const op = bitwise_op::AND;
+    digit_t operator()(digit_t a, digit_t b) const { return a & b; }
+};
+
+struct digit_or {
+    static bitwise_op const op = bitwise_op::OR;
+    digit_t operator()(digit_t a, digit_t b) const { return a | b; }
+};
+
+struct digit_xor {
+    static bitwise_op const op = bitwise_op::XOR;
+    digit_t operator()(digit_t a, digit_t b) const { return a ^ b; }
+};
+
+#ifdef BIGINT_SIGN_MAGNITUDE
+// переводит модуль в дополнительный код и обратно по одной цифре, carry изначально равен 1
+static digit_t twosComplementDigit(digit_t digit, bool negative, digit_t& carry) {
+    if (!negative) {
+        return digit;
+    }
+    digit_t result = ~digit + carry;
+    carry = (carry != 0 && result == 0 ? 1 : 0);
+    return result;
+}
+
+template <typename Operation>
+big_integer& big_integer::bit_operation(big_integer const& value, Operation operation) {
+    promote();
+    big_integer wide;
+    big_integer const& rhs = widened(value, wide);
+    size_t rhs_size = rhs.data_.size();
+    size_t max_size = std::max(data_.size(), rhs_size) + 1;
+    bool lhs_negative = negative_;
+    bool rhs_negative = rhs.negative_;
+    bool result_negative = operation(lhs_negative ? DIGIT_MAX : 0, rhs_negative ? DIGIT_MAX : 0) != 0;
     reserve(max_size);
+    digit_t lhs_carry = 1;
+    digit_t rhs_carry = 1;
+    digit_t result_carry = 1;
+    digit_t* out = mutableDigits().data;
+    digit_t const* in = rhs.digits().data;
     for (size_t i = 0; i < max_size; ++i) {
-        data_[i] = operation(data_[i], rhs.getDigit(i));
+        digit_t a = twosComplementDigit(out[i], lhs_negative, lhs_carry);
+        digit_t b = twosComplementDigit(i < rhs_size ? in[i] : 0, rhs_negative, rhs_carry);
+        out[i] = twosComplementDigit(operation(a, b), result_negative, result_carry);
     }
+    negative_ = result_negative;
     return trim();
 }
+#else
+template <typename Operation>
+big_integer& big_integer::bit_operation(big_integer const& value, Operation operation) {
+    promote();
+    big_integer wide;
+    big_integer const& rhs = widened(value, wide);
+    size_t rhs_size = rhs.data_.size();
+    digit_t fill = (rhs.isPositive() ? 0 : DIGIT_MAX);
+    reserve(rhs_size);
+    digit_span out = mutableDigits();
+    bitwiseVectors(out.data, rhs.digits().data, rhs_size, Operation::op);
+    // за концом rhs операция с fill: либо ничего не меняет, либо заполняет цифры, либо их инвертирует
+    if (operation(0, fill) != 0 || operation(DIGIT_MAX, fill) != DIGIT_MAX) {
+        bitwiseFill(out.data + rhs_size, out.size - rhs_size, fill, Operation::op);
+    }
+    return trim();
+}
+#endif
 
 big_integer& big_integer::operator&=(big_integer const& rhs) {
-    return bit_operation(rhs, [](uint32_t a, uint32_t b) { return a & b; });
+    if (isSmall() && rhs.isSmall()) {
+        small_ &= rhs.small_;
+        return *this;
+    }
+    return bit_operation(rhs, digit_and()).demote();
 }
 
 big_integer& big_integer::operator|=(big_integer const& rhs) {
-    return bit_operation(rhs, [](uint32_t a, uint32_t b) { return a | b; });
+    if (isSmall() && rhs.isSmall()) {
+        small_ |= rhs.small_;
+        return *this;
+    }
+    return bit_operation(rhs, digit_or()).demote();
 }
 
 big_integer& big_integer::operator^=(big_integer const& rhs)
 {
-    return bit_operation(rhs, [](uint32_t a, uint32_t b) { return a ^ b; });
+    if (isSmall() && rhs.isSmall()) {
+        small_ ^= rhs.small_;
+        return *this;
+    }
+    return bit_operation(rhs, digit_xor()).demote();
 }
 
 big_integer& big_integer::operator<<=(unsigned int rhs) {
     if (rhs == 0) {
         return *this;
     }
+    int64_t shifted;
+    if (isSmall() && rhs < 63 && !__builtin_mul_overflow(small_, static_cast<int64_t>(1) << rhs, &shifted)) {
+        small_ = shifted;
+        return *this;
+    }
+    promote();
     unsigned int digit_count = rhs / BIT_IN_DIGIT;
     unsigned int bit_count_l = rhs % BIT_IN_DIGIT;
     unsigned int bit_count_r =  BIT_IN_DIGIT - bit_count_l;
     size_t new_size = data_.size() + digit_count + (bit_count_l != 0 ? 1 : 0);
     reserve(new_size);
+    // после reserve старшая цифра уже заполнена знаком, все читаемые цифры лежат в out
+    digit_t* out = mutableDigits().data;
     if (bit_count_l != 0) {
         for (size_t i = new_size; i > digit_count + 1; --i) {
-            data_[i - 1] = (getDigit(i - digit_count - 1) << bit_count_l) +
-                           (getDigit(i - digit_count - 2) >> bit_count_r);
+            out[i - 1] = (out[i - digit_count - 1] << bit_count_l) +
+                         (out[i - digit_count - 2] >> bit_count_r);
         }
-        data_[digit_count] = (getDigit(0) << bit_count_l);
+        out[digit_count] = (out[0] << bit_count_l);
     } else {
         for (size_t i = new_size; i > digit_count; --i) {
-            data_[i - 1] = data_[i - digit_count - 1];
+            out[i - 1] = out[i - digit_count - 1];
         }
     }
-    for (size_t i = 0; i < digit_count; ++i) {
-        data_[i] = 0;
-    }
-    return trim();
+    std::fill(out, out + digit_count, 0u);
+    return trim().demote();
 }
 
 big_integer& big_integer::operator>>=(unsigned int rhs) {
     if (rhs == 0) {
         return *this;
     }
+    if (isSmall()) {            // арифметический сдвиг округляет вниз, как и для цифр
+        small_ >>= std::min(rhs, 63u);
+        return *this;
+    }
+#ifdef BIGINT_SIGN_MAGNITUDE
+    if (!isPositive()) {        // floor(-m / 2^k) = -((m - 1) / 2^k + 1)
+        --negateInPlace();
+        *this >>= rhs;
+        return (++*this).negateInPlace();
+    }
+#endif
     size_t digit_size = data_.size();
+    if (rhs / BIT_IN_DIGIT >= digit_size) {     // сдвигаются все цифры, остаётся знак
+        *this = (isPositive() ? 0 : -1);
+        return *this;
+    }
     unsigned int digit_count = rhs / BIT_IN_DIGIT;
     unsigned int bit_count_r = rhs % BIT_IN_DIGIT;
     unsigned int bit_count_l = BIT_IN_DIGIT - bit_count_r;
-    size_t i = 0;
+    size_t new_size = digit_size - digit_count;
+    digit_t fill = getDigit(digit_size);        // за старшей цифрой -- заполнение знаком
+    digit_t* out = mutableDigits().data;
     if (bit_count_r != 0) {
-        for (; i < digit_size - digit_count; ++i) {
-            data_[i] = (getDigit(i + digit_count) >> bit_count_r) +
-                       (getDigit(i + digit_count + 1) << bit_count_l);
+        for (size_t i = 0; i + 1 < new_size; ++i) {
+            out[i] = (out[i + digit_count] >> bit_count_r) + (out[i + digit_count + 1] << bit_count_l);
         }
+        out[new_size - 1] = (out[digit_size - 1] >> bit_count_r) + (fill << bit_count_l);
     } else {
-        for (; i < digit_size - digit_count; ++i) {
-            data_[i] = getDigit(i + digit_count);
-        }
-    }
-
-    for (; i < digit_size; ++i) {
-        data_.pop_back();
+        std::copy(out + digit_count, out + digit_size, out);
     }
-    return trim();
+    data_.resize(new_size);
+    return trim().demote();
 }
 
 big_integer big_integer::operator+() const {
@@ -234,11 +666,15 @@ big_integer big_integer::operator+() const {
 }
 
 big_integer big_integer::operator-() const {
-    return big_integer(*this).negateInPlace();
+    big_integer r = *this;
+    r.negateInPlace();
+    return r;
 }
 
 big_integer big_integer::operator~() const {
-    return big_integer(*this).inverseInPlace();
+    big_integer r = *this;
+    r.inverseInPlace();
+    return r;
 }
 
 big_integer& big_integer::operator++() {
@@ -261,44 +697,241 @@ big_integer big_integer::operator--(int) {
     return r;
 }
 
-big_integer operator+(big_integer a, big_integer const& b) {
-    return a += b;
+big_integer operator+(big_integer const& a, big_integer const& b) {
+    big_integer r = a;
+    r += b;
+    return r;
+}
+
+big_integer operator+(big_integer&& a, big_integer const& b) {
+    a += b;
+    return std::move(a);
+}
+
+big_integer operator+(big_integer const& a, big_integer&& b) {
+    b += a;
+    return std::move(b);
+}
+
+big_integer operator+(big_integer&& a, big_integer&& b) {
+    a += b;
+    return std::move(a);
+}
+
+big_integer operator-(big_integer const& a, big_integer const& b) {
+    big_integer r = a;
+    r -= b;
+    return r;
+}
+
+big_integer operator-(big_integer&& a, big_integer const& b) {
+    a -= b;
+    return std::move(a);
+}
+
+// a - b = -(b - a), буфер b переиспользуется
+big_integer operator-(big_integer const& a, big_integer&& b) {
+    b -= a;
+    b.negateInPlace();
+    return std::move(b);
+}
+
+big_integer operator-(big_integer&& a, big_integer&& b) {
+    a -= b;
+    return std::move(a);
+}
+
+big_integer operator*(big_integer const& a, big_integer const& b) {
+    big_integer r = a;
+    r *= b;
+    return r;
+}
+
+big_integer operator*(big_integer&& a, big_integer const& b) {
+    a *= b;
+    return std::move(a);
+}
+
+big_integer operator*(big_integer const& a, big_integer&& b) {
+    b *= a;
+    return std::move(b);
+}
+
+big_integer operator*(big_integer&& a, big_integer&& b) {
+    a *= b;
+    return std::move(a);
+}
+
+big_integer operator/(big_integer const& a, big_integer const& b) {
+    big_integer r = a;
+    r /= b;
+    return r;
+}
+
+big_integer operator/(big_integer&& a, big_integer const& b) {
+    a /= b;
+    return std::move(a);
 }
 
-big_integer operator-(big_integer a, big_integer const& b) {
-    return a -= b;
+big_integer operator%(big_integer const& a, big_integer const& b) {
+    big_integer r = a;
+    r %= b;
+    return r;
 }
 
-big_integer operator*(big_integer a, big_integer const& b) {
-    return a *= b;
+big_integer operator%(big_integer&& a, big_integer const& b) {
+    a %= b;
+    return std::move(a);
 }
 
-big_integer operator/(big_integer a, big_integer const& b) {
-    return a /= b;
+std::pair<big_integer, big_integer> divmod(big_integer const& a, big_integer const& b) {
+    std::pair<big_integer, big_integer> result(a, 0);
+    if (a.isSmall() && b.isSmall() && isSmallDivisionSafe(a.small_, b.small_)) {
+        result.first.small_ = a.small_ / b.small_;
+        result.second.small_ = a.small_ % b.small_;
+        return result;
+    }
+    result.first.divRemInPlace(b, &result.second);
+    result.first.demote();
+    result.second.demote();
+    return result;
 }
 
-big_integer operator%(big_integer a, big_integer const& b) {
-    return a %= b;
+// acc += a * b (или -=) для чисел в small_, false при переполнении
+static bool smallMulAdd(int64_t& acc, int64_t a, int64_t b, bool subtract) {
+    int64_t product;
+    int64_t result;
+    if (__builtin_mul_overflow(a, b, &product) ||
+        (subtract ? __builtin_sub_overflow(acc, product, &result) : __builtin_add_overflow(acc, product, &result))) {
+        return false;
+    }
+    acc = result;
+    return true;
 }
 
-big_integer operator&(big_integer a, big_integer const& b) {
-    return a &= b;
+big_integer& addmul(big_integer& acc, big_integer const& a, big_integer const& b) {
+    if (acc.isSmall() && a.isSmall() && b.isSmall() && smallMulAdd(acc.small_, a.small_, b.small_, false)) {
+        return acc;
+    }
+    return acc.mulAddInPlace(a, b, false);
 }
 
-big_integer operator|(big_integer a, big_integer const& b) {
-    return a |= b;
+big_integer& submul(big_integer& acc, big_integer const& a, big_integer const& b) {
+    if (acc.isSmall() && a.isSmall() && b.isSmall() && smallMulAdd(acc.small_, a.small_, b.small_, true)) {
+        return acc;
+    }
+    return acc.mulAddInPlace(a, b, true);
 }
 
-big_integer operator^(big_integer a, big_integer const& b) {
-    return a ^= b;
+big_integer& addmul(big_integer& acc, big_integer const& a, uint32_t b) {
+    return addmul(acc, a, static_cast<uint64_t>(b));
 }
 
-big_integer operator<<(big_integer a, unsigned int b) {
-    return a <<= b;
+big_integer& submul(big_integer& acc, big_integer const& a, uint32_t b) {
+    return submul(acc, a, static_cast<uint64_t>(b));
+}
+
+big_integer& addmul(big_integer& acc, big_integer const& a, uint64_t b) {
+    if (acc.isSmall() && a.isSmall() && b <= INT64_MAX &&
+        smallMulAdd(acc.small_, a.small_, static_cast<int64_t>(b), false)) {
+        return acc;
+    }
+    digit_t digits[sizeof(uint64_t) / sizeof(digit_t)];
+    return acc.mulAddInPlace(a, digits, toDigits(b, digits), false);
+}
+
+big_integer& submul(big_integer& acc, big_integer const& a, uint64_t b) {
+    if (acc.isSmall() && a.isSmall() && b <= INT64_MAX &&
+        smallMulAdd(acc.small_, a.small_, static_cast<int64_t>(b), true)) {
+        return acc;
+    }
+    digit_t digits[sizeof(uint64_t) / sizeof(digit_t)];
+    return acc.mulAddInPlace(a, digits, toDigits(b, digits), true);
+}
+
+big_integer operator&(big_integer const& a, big_integer const& b) {
+    big_integer r = a;
+    r &= b;
+    return r;
+}
+
+big_integer operator&(big_integer&& a, big_integer const& b) {
+    a &= b;
+    return std::move(a);
+}
+
+big_integer operator&(big_integer const& a, big_integer&& b) {
+    b &= a;
+    return std::move(b);
+}
+
+big_integer operator&(big_integer&& a, big_integer&& b) {
+    a &= b;
+    return std::move(a);
+}
+
+big_integer operator|(big_integer const& a, big_integer const& b) {
+    big_integer r = a;
+    r |= b;
+    return r;
 }
 
-big_integer operator>>(big_integer a, unsigned int b) {
-    return a >>= b;
+big_integer operator|(big_integer&& a, big_integer const& b) {
+    a |= b;
+    return std::move(a);
+}
+
+big_integer operator|(big_integer const& a, big_integer&& b) {
+    b |= a;
+    return std::move(b);
+}
+
+big_integer operator|(big_integer&& a, big_integer&& b) {
+    a |= b;
+    return std::move(a);
+}
+
+big_integer operator^(big_integer const& a, big_integer const& b) {
+    big_integer r = a;
+    r ^= b;
+    return r;
+}
+
+big_integer operator^(big_integer&& a, big_integer const& b) {
+    a ^= b;
+    return std::move(a);
+}
+
+big_integer operator^(big_integer const& a, big_integer&& b) {
+    b ^= a;
+    return std::move(b);
+}
+
+big_integer operator^(big_integer&& a, big_integer&& b) {
+    a ^= b;
+    return std::move(a);
+}
+
+big_integer operator<<(big_integer const& a, unsigned int b) {
+    big_integer r = a;
+    r <<= b;
+    return r;
+}
+
+big_integer operator<<(big_integer&& a, unsigned int b) {
+    a <<= b;
+    return std::move(a);
+}
+
+big_integer operator>>(big_integer const& a, unsigned int b) {
+    big_integer r = a;
+    r >>= b;
+    return r;
+}
+
+big_integer operator>>(big_integer&& a, unsigned int b) {
+    a >>= b;
+    return std::move(a);
 }
 
 bool big_integer::vectorAbsSmaller(big_integer const& a, big_integer const& b) {
@@ -311,6 +944,13 @@ bool big_integer::vectorAbsSmaller(big_integer const& a, big_integer const& b) {
 }
 
 bool operator==(big_integer const& a, big_integer const& b) {
+    if (a.isSmall() || b.isSmall()) {
+        if (a.isSmall() && b.isSmall()) {
+            return a.small_ == b.small_;
+        }
+        big_integer wide;
+        return (a.isSmall() ? big_integer::widened(a, wide) == b : a == big_integer::widened(b, wide));
+    }
     if (a.isPositive() != b.isPositive() || a.data_.size() != b.data_.size()) {
         return false;
     }
@@ -322,13 +962,24 @@ bool operator!=(big_integer const& a, big_integer const& b) {
 }
 
 bool operator<(big_integer const& a, big_integer const& b) {
+    if (a.isSmall() || b.isSmall()) {
+        if (a.isSmall() && b.isSmall()) {
+            return a.small_ < b.small_;
+        }
+        big_integer wide;
+        return (a.isSmall() ? big_integer::widened(a, wide) < b : a < big_integer::widened(b, wide));
+    }
     if (a.isPositive() != b.isPositive()) {
         return b.isPositive();
     }
+#ifdef BIGINT_SIGN_MAGNITUDE
+    return (a.isPositive() ? big_integer::vectorAbsSmaller(a, b) : big_integer::vectorAbsSmaller(b, a));
+#else
     if (a.data_.size() != b.data_.size()) {
         return a.isPositive() == (a.data_.size() < b.data_.size());
     }
     return big_integer::vectorAbsSmaller(a, b);
+#endif
 }
 
 bool operator>(big_integer const& a, big_integer const& b) {
@@ -343,43 +994,312 @@ bool operator>=(big_integer const& a, big_integer const& b) {
     return !(a < b);
 }
 
+// пишет x < radixChunk^(2^level) ровно в digits * 2^level символов с ведущими нулями, x портится
+void big_integer::writeRadix(big_integer& x, unsigned radix, std::vector<big_integer> const& powers,
+                             size_t level, char* out) {
+    x.promote();
+    size_t digits;
+    digit_t chunk = radixChunk(radix, digits);
+    size_t length = digits << level;
+    if (level == 0 || x.magnitudeSize() <= TO_STRING_BASE_SIZE) {
+        char* pos = out + length;
+        while (pos != out && x != 0) {
+            digit_t rem = x.divRemAbsDigitInPlace(chunk);
+            for (size_t i = 0; i < digits; ++i) {
+                *--pos = RADIX_DIGITS[rem % radix];
+                rem /= radix;
+            }
+        }
+        std::fill(out, pos, '0');
+        return;
+    }
+    // x = q * radixChunk^(2^(level - 1)) + r, половины печатаются независимо
+    big_integer remainder;
+    x.divRemInPlace(powers[level - 1], &remainder);
+    writeRadix(x, radix, powers, level - 1, out);
+    writeRadix(remainder, radix, powers, level - 1, out + length / 2);
+}
+
+// пишет модуль x ровно в length символов, по bits битов на символ
+void big_integer::writePowerOfTwo(big_integer const& x, unsigned bits, char* out, size_t length) {
+    size_t size = x.magnitudeSize();
+    digit_t const* in = x.digits().data;
+    digit_t mask = (1u << bits) - 1;
+    size_t pos = 0;
+    for (size_t i = length; i > 0; --i, pos += bits) {
+        size_t digit = pos / BIT_IN_DIGIT;
+        double_digit_t value = in[digit];
+        if (digit + 1 < size) {
+            value |= static_cast<double_digit_t>(in[digit + 1]) << BIT_IN_DIGIT;
+        }
+        out[i - 1] = RADIX_DIGITS[(value >> (pos % BIT_IN_DIGIT)) & mask];
+    }
+}
+
 std::string to_string(big_integer const& a) {
+    return to_string(a, 10);
+}
+
+std::string to_string(big_integer const& a, unsigned radix) {
+    checkRadix(radix);
+    if (a.isSmall() && radix == 10) {
+        return std::to_string(a.small_);
+    }
     if (a == 0) {
         return "0";
     }
-    int const divisor = 1000000000;
-    std::vector<uint32_t> buffer;
-    std::stringstream s;
-    big_integer r = a.abs();
-    while (r > 0) {
-        buffer.push_back((r % divisor).data_[0]);
-        r.divAbsLongDigitInPlace(divisor);
+    big_integer x = a.abs();
+    x.promote();
+    std::string result;
+    if (isPowerOfTwo(radix)) {
+        unsigned bits = big_integer::bitCount(radix - 1);
+        result.assign(1 + (x.magnitudeSize() * big_integer::BIT_IN_DIGIT + bits - 1) / bits, '0');
+        big_integer::writePowerOfTwo(x, bits, &result[1], result.size() - 1);
+    } else {
+        // в цифре 32 * log_radix(2) символов
+        size_t length = static_cast<size_t>(x.magnitudeSize() * big_integer::BIT_IN_DIGIT
+                                            * std::log(2.0) / std::log(radix)) + 2;
+        size_t digits;
+        radixChunk(radix, digits);
+        size_t level = 0;
+        while ((digits << level) < length) {
+            ++level;
+        }
+        result.assign(1 + (digits << level), '0');
+        std::vector<big_integer> buffer;
+        big_integer::writeRadix(x, radix, radixPowers(radix, level, buffer), level, &result[1]);
     }
-
+    size_t first = result.find_first_not_of('0', 1);
     if (!a.isPositive()) {
-        s << "-";
-    }
-    s << buffer.back();
-    for (auto i = buffer.rbegin() + 1; i != buffer.rend(); ++i) {
-        char nine_chars[10];
-        sprintf(nine_chars, "%09d", *i);
-        s << nine_chars;
+        result[--first] = '-';
     }
-    return s.str();
+    return result.erase(0, first);
 }
 
 std::ostream& operator<<(std::ostream& s, big_integer const& a) {
     return s << to_string(a);
 }
 
+#ifdef BIGINT_SIGN_MAGNITUDE
 bool big_integer::isPositive() const {
-    return isPositive(data_.back());
+    return (isSmall() ? small_ >= 0 : !negative_);
+}
+
+void big_integer::promote() {
+    if (!isSmall()) {
+        return;
+    }
+    negative_ = (small_ < 0);
+    uint64_t magnitude = static_cast<uint64_t>(small_);
+    if (negative_) {
+        magnitude = 0 - magnitude;
+    }
+    data_.resize(SMALL_DIGITS);
+    digit_t* out = mutableDigits().data;
+    for (size_t i = 0; i < SMALL_DIGITS; ++i) {
+        out[i] = static_cast<digit_t>(magnitude);
+        magnitude = shiftOutDigit(magnitude);
+    }
+    trim();
+}
+
+big_integer& big_integer::demote() {
+    if (isSmall() || data_.size() > SMALL_DIGITS) {
+        return *this;
+    }
+    uint64_t magnitude = 0;
+    const_digit_span in = digits();
+    for (size_t i = in.size; i > 0; --i) {
+        magnitude = shiftInDigit(magnitude, in[i - 1]);
+    }
+    if (magnitude > static_cast<uint64_t>(INT64_MAX) + (negative_ ? 1 : 0)) {
+        return *this;
+    }
+    small_ = static_cast<int64_t>(negative_ ? 0 - magnitude : magnitude);
+    negative_ = false;
+    data_.clear();
+    return *this;
 }
 
 big_integer& big_integer::trim() {
-    while (data_.size() > 1 && (data_.back() == 0 || data_.back() == UINT32_MAX) &&
-           ((data_.back() == 0) == isPositive(data_[data_.size() - 2]))) {
-        data_.pop_back();
+    const_digit_span d = digits();
+    size_t n = d.size;
+    while (n > 1 && d[n - 1] == 0) {
+        --n;
+    }
+    if (n != d.size) {
+        data_.resize(n);
+    }
+    if (n == 1 && d[0] == 0) {
+        negative_ = false;
+    }
+    return *this;
+}
+
+big_integer& big_integer::absInPlace() {
+    if (isSmall()) {
+        return (small_ < 0 ? negateInPlace() : *this);
+    }
+    negative_ = false;
+    return *this;
+}
+
+void big_integer::reserve(size_t new_size) {
+    if (data_.size() < new_size) {
+        data_.resize(new_size);
+    }
+}
+
+size_t big_integer::magnitudeSize() const {
+    return data_.size();
+}
+
+digit_t big_integer::getDigit(size_t i) const {
+    return (i < data_.size() ? data_[i] : 0);
+}
+
+big_integer& big_integer::negateInPlace() {
+    if (isSmall() && small_ != INT64_MIN) {
+        small_ = -small_;
+        return *this;
+    }
+    promote();
+    negative_ = !negative_;
+    return trim();
+}
+
+size_t big_integer::absSize() const {
+    if (isSmall()) {
+        digit_t digits[SMALL_DIGITS];
+        return smallAbsDigits(digits);
+    }
+    const_digit_span d = digits();
+    return (d.size == 1 && d[0] == 0 ? 0 : d.size);
+}
+
+void big_integer::copyAbsDigits(digit_t* out) const {
+    if (isSmall()) {
+        smallAbsDigits(out);
+        return;
+    }
+    size_t n = absSize();
+    if (n != 0) {
+        std::copy_n(digits().data, n, out);
+    }
+}
+
+digit_t big_integer::absTopDigit() const {
+    if (isSmall()) {
+        digit_t digits[SMALL_DIGITS];
+        size_t n = smallAbsDigits(digits);
+        return (n == 0 ? 0 : digits[n - 1]);
+    }
+    size_t n = absSize();
+    return (n == 0 ? 0 : digits()[n - 1]);
+}
+
+big_integer& big_integer::mulAddInPlace(big_integer const& a, big_integer const& b, bool subtract) {
+    if (&b == this) {
+        big_integer copy = *this;
+        return mulAddInPlace(&a == this ? copy : a, copy, subtract);
+    }
+    big_integer wide;
+    big_integer const& rhs = widened(b, wide);
+    size_t m = rhs.absSize();
+    if (m == 0) {
+        return *this;
+    }
+    return mulAddInPlace(a, rhs.digits().data, m, rhs.negative_ != subtract);
+}
+
+big_integer& big_integer::mulAddInPlace(big_integer const& value, digit_t const* b, size_t m, bool subtract) {
+    if (&value == this) {
+        big_integer copy = *this;
+        return mulAddInPlace(copy, b, m, subtract);
+    }
+    big_integer wide;
+    big_integer const& a = widened(value, wide);
+    size_t n = a.absSize();
+    if (n == 0 || m == 0) {
+        return *this;
+    }
+    promote();
+    bool termNegative = (a.negative_ != subtract);
+    reserve(std::max(data_.size(), n + m) + 1);
+    digit_span r = mutableDigits();
+    if (termNegative == negative_) {
+        addMulVectors(r.data, r.size, a.digits().data, n, b, m);
+    } else if (subMulVectors(r.data, r.size, a.digits().data, n, b, m) != 0) {
+        // |a * b| > |*this|: в r лежит B^size - (|a * b| - |*this|), меняем знак
+        bitwiseFill(r.data, r.size, DIGIT_MAX, bitwise_op::XOR);
+        size_t i = 0;
+        while (++r[i] == 0) {
+            ++i;
+        }
+        negative_ = !negative_;
+    }
+    return trim().demote();
+}
+
+big_integer big_integer::fromAbsDigits(digit_t const* in, size_t n, bool negative) {
+    big_integer result;
+    if (n == 0) {
+        return result;
+    }
+    result.data_.resize(n);
+    std::copy_n(in, n, result.mutableDigits().data);
+    result.negative_ = negative;
+    return result.trim().demote();
+}
+
+big_integer& big_integer::inverseInPlace() {
+    if (isSmall()) {
+        small_ = ~small_;
+        return *this;
+    }
+    return --negateInPlace();
+}
+#else
+bool big_integer::isPositive() const {
+    return (isSmall() ? small_ >= 0 : isPositive(data_.back()));
+}
+
+void big_integer::promote() {
+    if (!isSmall()) {
+        return;
+    }
+    uint64_t value = static_cast<uint64_t>(small_);
+    data_.resize(SMALL_DIGITS);
+    digit_t* out = mutableDigits().data;
+    for (size_t i = 0; i < SMALL_DIGITS; ++i) {
+        out[i] = static_cast<digit_t>(value);
+        value = shiftOutDigit(value);
+    }
+    trim();
+}
+
+big_integer& big_integer::demote() {
+    if (isSmall() || data_.size() > SMALL_DIGITS) {
+        return *this;
+    }
+    uint64_t value = (isPositive() ? 0 : UINT64_MAX);
+    const_digit_span in = digits();
+    for (size_t i = in.size; i > 0; --i) {
+        value = shiftInDigit(value, in[i - 1]);
+    }
+    small_ = static_cast<int64_t>(value);
+    data_.clear();
+    return *this;
+}
+
+big_integer& big_integer::trim() {
+    const_digit_span d = digits();
+    size_t n = d.size;
+    while (n > 1 && (d[n - 1] == 0 || d[n - 1] == DIGIT_MAX) && ((d[n - 1] == 0) == isPositive(d[n - 2]))) {
+        --n;
+    }
+    if (n != d.size) {
+        data_.resize(n);
     }
     return *this;
 }
@@ -396,58 +1316,218 @@ void big_integer::reserve(size_t new_size) {
     if (data_.size() >= new_size) {
         return;
     }
-    uint32_t filler = (isPositive() ? 0 : UINT32_MAX);
-    for (size_t i = data_.size(); i < new_size; ++i) {
-        data_.push_back(filler);
+    bool negative = !isPositive();
+    size_t old_size = data_.size();
+    data_.resize(new_size);
+    if (negative) {
+        bitwiseFill(mutableDigits().data + old_size, new_size - old_size, DIGIT_MAX, bitwise_op::ASSIGN);
     }
 }
 
-uint32_t big_integer::getDigit(size_t i) const {
+size_t big_integer::magnitudeSize() const {
+    return data_.size() - (data_.size() > 1 && data_.back() == 0 ? 1 : 0);
+}
+
+digit_t big_integer::getDigit(size_t i) const {
     if (i < data_.size()) {
         return data_[i];
     } else {
        if (isPositive()) {
            return 0;
        } else {
-           return UINT32_MAX;
+           return DIGIT_MAX;
        }
     }
 }
 
-uint32_t big_integer::getDigit(size_t i, bool sign) const {
-    if (i < data_.size()) {
-        return data_[i];
-    } else {
-        return sign ? 0 : UINT32_MAX;
+bool big_integer::isPositive(digit_t x) {
+    return (x >> (DIGIT_BITS - 1)) == 0;
+}
+
+// |x| = ~x + 1: младшие нулевые цифры остаются нулями, перенос не идёт дальше первой ненулевой
+size_t big_integer::absSize() const {
+    if (isSmall()) {
+        digit_t digits[SMALL_DIGITS];
+        return smallAbsDigits(digits);
     }
+    const_digit_span d = digits();
+    if (isPositive()) {
+        size_t n = magnitudeSize();
+        return (n == 1 && d[0] == 0 ? 0 : n);
+    }
+    size_t low = 0;
+    while (d[low] == 0) {
+        ++low;
+    }
+    size_t n = d.size;
+    while (n > low + 1 && d[n - 1] == DIGIT_MAX) {
+        --n;
+    }
+    return n;
 }
 
-uint32_t big_integer::bitCount(uint32_t d) {
-    uint32_t count = 0;
-    while (d > 0) {
-        ++count;
-        d /= 2;
+void big_integer::copyAbsDigits(digit_t* out) const {
+    if (isSmall()) {
+        smallAbsDigits(out);
+        return;
+    }
+    size_t n = absSize();
+    if (isPositive()) {
+        if (n != 0) {
+            std::copy_n(digits().data, n, out);
+        }
+        return;
+    }
+    digit_t const* in = digits().data;
+    size_t i = 0;
+    for (; in[i] == 0; ++i) {
+        out[i] = 0;
+    }
+    out[i] = 0u - in[i];
+    for (++i; i < n; ++i) {
+        out[i] = ~in[i];
     }
-    return count;
 }
 
-bool big_integer::isPositive(uint32_t x) {
-    return (x >> 31u) == 0;
+digit_t big_integer::absTopDigit() const {
+    if (isSmall()) {
+        digit_t digits[SMALL_DIGITS];
+        size_t n = smallAbsDigits(digits);
+        return (n == 0 ? 0 : digits[n - 1]);
+    }
+    size_t n = absSize();
+    const_digit_span d = digits();
+    if (n == 0 || isPositive()) {
+        return (n == 0 ? 0 : d[n - 1]);
+    }
+    size_t low = 0;
+    while (d[low] == 0) {
+        ++low;
+    }
+    return (n - 1 == low ? 0u - d[low] : ~d[n - 1]);
+}
+
+digit_t const* big_integer::absDigits(std::vector<digit_t>& buffer) const {
+    if (isPositive() && !isSmall()) {
+        return digits().data;
+    }
+    buffer.resize(absSize());
+    copyAbsDigits(buffer.data());
+    return buffer.data();
+}
+
+big_integer& big_integer::mulAddInPlace(big_integer const& a, big_integer const& b, bool subtract) {
+    if (&b == this) {
+        big_integer copy = *this;
+        return mulAddInPlace(&a == this ? copy : a, copy, subtract);
+    }
+    size_t m = b.absSize();
+    if (m == 0) {
+        return *this;
+    }
+    std::vector<digit_t> bBuffer;
+    digit_t const* bDigits = b.absDigits(bBuffer);
+    return mulAddInPlace(a, bDigits, m, b.isPositive() ? subtract : !subtract);
+}
+
+big_integer& big_integer::mulAddInPlace(big_integer const& a, digit_t const* b, size_t m, bool subtract) {
+    if (&a == this) {
+        big_integer copy = *this;
+        return mulAddInPlace(copy, b, m, subtract);
+    }
+    size_t n = a.absSize();
+    if (n == 0 || m == 0) {
+        return *this;
+    }
+    std::vector<digit_t> aBuffer;
+    digit_t const* aDigits = a.absDigits(aBuffer);
+    // в дополнительном коде достаточно прибавить или вычесть |a * b| по модулю B^size
+    promote();
+    reserve(std::max(data_.size(), n + m) + 1);
+    digit_span r = mutableDigits();
+    if (a.isPositive() != subtract) {
+        addMulVectors(r.data, r.size, aDigits, n, b, m);
+    } else {
+        subMulVectors(r.data, r.size, aDigits, n, b, m);
+    }
+    return trim().demote();
+}
+
+big_integer big_integer::fromAbsDigits(digit_t const* in, size_t n, bool negative) {
+    big_integer result;
+    if (n == 0) {
+        return result;
+    }
+    result.data_.resize(n + 1);
+    digit_t* out = result.mutableDigits().data;
+    size_t i = 0;
+    if (!negative) {
+        for (; i < n; ++i) {
+            out[i] = in[i];
+        }
+        return result.trim().demote();
+    }
+    for (; i < n && in[i] == 0; ++i) {
+        out[i] = 0;
+    }
+    if (i == n) {
+        return result.trim().demote();
+    }
+    out[i] = 0u - in[i];
+    for (++i; i < n; ++i) {
+        out[i] = ~in[i];
+    }
+    out[n] = DIGIT_MAX;
+    return result.trim().demote();
 }
 
 big_integer& big_integer::negateInPlace() {
+    if (isSmall() && small_ != INT64_MIN) {
+        small_ = -small_;
+        return *this;
+    }
+    promote();
+    // -x = ~x + 1, лишняя старшая цифра нужна, когда -x длиннее x
     reserve(data_.size() + 1);
-    ++inverseInPlace();
+    digit_span out = mutableDigits();
+    bitwiseFill(out.data, out.size, DIGIT_MAX, bitwise_op::XOR);
+    size_t i = 0;
+    while (i < out.size && ++out[i] == 0) {
+        ++i;
+    }
     return trim();
 }
 
 big_integer& big_integer::inverseInPlace() {
-    for (auto &i : data_) {
-        i = ~i;
+    if (isSmall()) {
+        small_ = ~small_;
+        return *this;
     }
+    digit_span out = mutableDigits();
+    bitwiseFill(out.data, out.size, DIGIT_MAX, bitwise_op::XOR);
     return trim();
 }
+#endif
+
+const_digit_span big_integer::digits() const {
+    return {data_.data(), data_.size()};
+}
+
+digit_span big_integer::mutableDigits() {
+    return {data_.data(), data_.size()};
+}
+
+digit_t big_integer::bitCount(digit_t d) {
+    digit_t count = 0;
+    while (d > 0) {
+        ++count;
+        d /= 2;
+    }
+    return count;
+}
 
 big_integer big_integer::abs() const {
-    return big_integer(*this).absInPlace();
+    big_integer r = *this;
+    r.absInPlace();
+    return r;
 }
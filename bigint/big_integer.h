@@ -1,10 +1,13 @@
 #ifndef BIG_INTEGER_H
 #define BIG_INTEGER_H
 
+#include <string>
 #include <vector>
-#include <functional>
+#include <type_traits>
+#include <utility>
+#include "digit_span.h"
 
-using storage_t = std::vector<uint32_t>;
+using storage_t = std::vector<digit_t>;
 
 struct big_integer
 {
@@ -12,8 +15,12 @@ struct big_integer
     big_integer(int);
     big_integer(uint32_t);
     explicit big_integer(std::string const&);
+    big_integer(std::string const&, unsigned radix);
     big_integer(big_integer const&) = default;
     big_integer& operator=(big_integer const&) = default;
+    // перемещённое число становится нулём
+    big_integer(big_integer&&) noexcept;
+    big_integer& operator=(big_integer&&) noexcept;
 
     big_integer& operator+=(big_integer const&);
     big_integer& operator-=(big_integer const&);
@@ -51,44 +58,141 @@ struct big_integer
     friend bool operator<=(big_integer const&, big_integer const&);
     friend bool operator>=(big_integer const&, big_integer const&);
 
+    friend std::pair<big_integer, big_integer> divmod(big_integer const&, big_integer const&);
+    friend big_integer& addmul(big_integer&, big_integer const&, big_integer const&);
+    friend big_integer& submul(big_integer&, big_integer const&, big_integer const&);
+    friend big_integer& addmul(big_integer&, big_integer const&, uint32_t);
+    friend big_integer& submul(big_integer&, big_integer const&, uint32_t);
+    friend big_integer& addmul(big_integer&, big_integer const&, uint64_t);
+    friend big_integer& submul(big_integer&, big_integer const&, uint64_t);
     friend std::string to_string(big_integer const&);
+    friend std::string to_string(big_integer const&, unsigned radix);
+    friend size_t serializedSize(big_integer const&);
+    friend void serialize(big_integer const&, unsigned char*);
+    friend big_integer deserialize(unsigned char const*, size_t);
+    friend struct big_integer_expr;
 
 private:
+#ifdef BIGINT_SIGN_MAGNITUDE
+    storage_t data_; //храним модуль в little endian, ноль всегда неотрицателен
+    bool negative_;
+#else
     storage_t data_; //храним в little endian в дополнительном коде
-    static const size_t BIT_IN_DIGIT = 8 * sizeof(uint32_t);
-
-    big_integer& shiftedAbstractInPlace(big_integer const &, size_t, uint32_t,
-                            std::function<uint32_t(uint32_t)> const&, bool);
+#endif
+    int64_t small_; //значение числа, пока data_ пуст: помещающиеся в 64 бита числа не выделяют памяти
+    static const size_t BIT_IN_DIGIT = DIGIT_BITS;
+
+#ifdef BIGINT_SIGN_MAGNITUDE
+    big_integer& shiftedAbstractInPlace(big_integer const&, size_t, bool);
+#else
+    template <typename Operation>
+    big_integer& shiftedAbstractInPlace(big_integer const&, size_t, digit_t, Operation, bool);
     big_integer& shiftedSubVectorInPlace(big_integer const&, size_t);
+#endif
     big_integer& shiftedSubInPlace(big_integer const&, size_t);
     big_integer& shiftedAddInPlace(big_integer const&, size_t);
-    big_integer& divAbsLongDigitInPlace(uint32_t x);
+    digit_t divRemAbsDigitInPlace(digit_t x);
+    big_integer& divRemInPlace(big_integer const&, big_integer*);
+    // *this += a * b (или -=) без промежуточного big_integer
+    big_integer& mulAddInPlace(big_integer const&, big_integer const&, bool);
+    // то же для неотрицательного множителя, заданного цифрами
+    big_integer& mulAddInPlace(big_integer const&, digit_t const*, size_t, bool);
+    static big_integer parseRadix(char const*, size_t, unsigned, std::vector<big_integer> const&, size_t);
+    static big_integer parsePowerOfTwo(char const*, size_t, unsigned);
+    static void writeRadix(big_integer&, unsigned, std::vector<big_integer> const&, size_t, char*);
+    static void writePowerOfTwo(big_integer const&, unsigned, char*, size_t);
 
     big_integer& trim();
+    // small_ <-> data_: demote возвращает число в small_, только если оно туда помещается
+    bool isSmall() const;
+    void promote();
+    big_integer& demote();
+    size_t smallAbsDigits(digit_t*) const;
+    // x в виде цифр: сам x или его копия в buffer
+    static big_integer const& widened(big_integer const& x, big_integer& buffer);
+    // цифры data_ одним куском: ядра берут их один раз, а не обращаются к data_[i] на каждой цифре
+    const_digit_span digits() const;
+    digit_span mutableDigits();
     void reserve(size_t);
-    uint32_t getDigit(size_t) const;
-    uint32_t getDigit(size_t, bool) const;
-
-    big_integer& bit_operation(big_integer const&,
-                               std::function<uint32_t(uint32_t, uint32_t)> const&);
-
-    static uint32_t bitCount(uint32_t);
-    static bool isPositive(uint32_t);
+    size_t magnitudeSize() const;
+    // модуль как массив цифр без старших нулей (у нуля пустой)
+    size_t absSize() const;
+    void copyAbsDigits(digit_t*) const;
+    digit_t absTopDigit() const;
+    static big_integer fromAbsDigits(digit_t const*, size_t, bool);
+    digit_t getDigit(size_t) const;
+#ifndef BIGINT_SIGN_MAGNITUDE
+    // модуль без копирования, если число неотрицательно, иначе -- копия в buffer
+    digit_t const* absDigits(std::vector<digit_t>& buffer) const;
+#endif
+
+    template <typename Operation>
+    big_integer& bit_operation(big_integer const&, Operation);
+
+    static digit_t bitCount(digit_t);
+#ifndef BIGINT_SIGN_MAGNITUDE
+    static bool isPositive(digit_t);
+#endif
     static bool vectorAbsSmaller(big_integer const&, big_integer const&);
 };
 
-big_integer operator+(big_integer, big_integer const&);
-big_integer operator-(big_integer, big_integer const&);
-big_integer operator*(big_integer, big_integer const&);
-big_integer operator/(big_integer, big_integer const&);
-big_integer operator%(big_integer, big_integer const&);
-
-big_integer operator&(big_integer, big_integer const&);
-big_integer operator|(big_integer, big_integer const&);
-big_integer operator^(big_integer, big_integer const&);
-
-big_integer operator<<(big_integer, unsigned int);
-big_integer operator>>(big_integer, unsigned int);
+big_integer operator+(big_integer const&, big_integer const&);
+big_integer operator+(big_integer&&, big_integer const&);
+big_integer operator+(big_integer const&, big_integer&&);
+big_integer operator+(big_integer&&, big_integer&&);
+big_integer operator-(big_integer const&, big_integer const&);
+big_integer operator-(big_integer&&, big_integer const&);
+big_integer operator-(big_integer const&, big_integer&&);
+big_integer operator-(big_integer&&, big_integer&&);
+big_integer operator*(big_integer const&, big_integer const&);
+big_integer operator*(big_integer&&, big_integer const&);
+big_integer operator*(big_integer const&, big_integer&&);
+big_integer operator*(big_integer&&, big_integer&&);
+big_integer operator/(big_integer const&, big_integer const&);
+big_integer operator/(big_integer&&, big_integer const&);
+big_integer operator%(big_integer const&, big_integer const&);
+big_integer operator%(big_integer&&, big_integer const&);
+// частное и остаток за одно деление, округление к нулю как у / и %
+std::pair<big_integer, big_integer> divmod(big_integer const&, big_integer const&);
+// acc += a * b и acc -= a * b прямо в цифрах acc, без промежуточного произведения
+big_integer& addmul(big_integer& acc, big_integer const& a, big_integer const& b);
+big_integer& submul(big_integer& acc, big_integer const& a, big_integer const& b);
+big_integer& addmul(big_integer& acc, big_integer const& a, uint32_t b);
+big_integer& submul(big_integer& acc, big_integer const& a, uint32_t b);
+big_integer& addmul(big_integer& acc, big_integer const& a, uint64_t b);
+big_integer& submul(big_integer& acc, big_integer const& a, uint64_t b);
+
+// остальные встроенные целые (в том числе литералы вроде 3 и -7) -- через модуль в uint64_t;
+// шаблон точно совпадает с типом аргумента, поэтому вызов не конфликтует с перегрузками выше
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, big_integer&>::type
+addmul(big_integer& acc, big_integer const& a, T b) {
+    return (b < 0 ? submul(acc, a, 0 - static_cast<uint64_t>(b)) : addmul(acc, a, static_cast<uint64_t>(b)));
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, big_integer&>::type
+submul(big_integer& acc, big_integer const& a, T b) {
+    return (b < 0 ? addmul(acc, a, 0 - static_cast<uint64_t>(b)) : submul(acc, a, static_cast<uint64_t>(b)));
+}
+
+big_integer operator&(big_integer const&, big_integer const&);
+big_integer operator&(big_integer&&, big_integer const&);
+big_integer operator&(big_integer const&, big_integer&&);
+big_integer operator&(big_integer&&, big_integer&&);
+big_integer operator|(big_integer const&, big_integer const&);
+big_integer operator|(big_integer&&, big_integer const&);
+big_integer operator|(big_integer const&, big_integer&&);
+big_integer operator|(big_integer&&, big_integer&&);
+big_integer operator^(big_integer const&, big_integer const&);
+big_integer operator^(big_integer&&, big_integer const&);
+big_integer operator^(big_integer const&, big_integer&&);
+big_integer operator^(big_integer&&, big_integer&&);
+
+big_integer operator<<(big_integer const&, unsigned int);
+big_integer operator<<(big_integer&&, unsigned int);
+big_integer operator>>(big_integer const&, unsigned int);
+big_integer operator>>(big_integer&&, unsigned int);
 
 bool operator==(big_integer const&, big_integer const&);
 bool operator!=(big_integer const&, big_integer const&);
@@ -98,6 +202,7 @@ bool operator<=(big_integer const&, big_integer const&);
 bool operator>=(big_integer const&, big_integer const&);
 
 std::string to_string(big_integer const&);
+std::string to_string(big_integer const&, unsigned radix);
 std::ostream& operator<<(std::ostream& s, big_integer const&);
 
 #endif // BIG_INTEGER_H
@@ -0,0 +1,131 @@
+#include "big_integer_expr.h"
+
+void big_integer_expr::accumulate(big_integer& r, big_integer_product const& term, bool subtract) {
+    r.mulAddInPlace(term.a, term.b, subtract);
+}
+
+void big_integer_expr::accumulate(big_integer& r, big_integer_shifted const& term, bool subtract) {
+    if (&term.a == &r) {
+        big_integer copy = r;
+        accumulate(r, big_integer_shifted{copy, term.shift}, subtract);
+        return;
+    }
+    size_t digits = term.shift / DIGIT_BITS;
+    unsigned bits = term.shift % DIGIT_BITS;
+    // сдвиг на целые цифры складывается на месте, остаток сдвига требует одной копии
+    big_integer shifted;
+    if (bits != 0) {
+        shifted = term.a << bits;
+    }
+    big_integer const& rhs = (bits != 0 ? shifted : term.a);
+    if (subtract) {
+        r.shiftedSubInPlace(rhs, digits);
+    } else {
+        r.shiftedAddInPlace(rhs, digits);
+    }
+}
+
+big_integer_product::operator big_integer() const {
+    big_integer r = a;
+    return r *= b;
+}
+
+big_integer_shifted::operator big_integer() const {
+    return a << shift;
+}
+
+big_integer_lazy lazy(big_integer const& a) {
+    return big_integer_lazy{a};
+}
+
+big_integer_product operator*(big_integer_lazy a, big_integer const& b) {
+    return big_integer_product{a.value, b};
+}
+
+big_integer_shifted operator<<(big_integer_lazy a, unsigned shift) {
+    return big_integer_shifted{a.value, shift};
+}
+
+big_integer_sum<big_integer_product> operator+(big_integer const& base, big_integer_product const& term) {
+    return big_integer_sum<big_integer_product>{base, term, false};
+}
+
+big_integer_sum<big_integer_product> operator+(big_integer_product const& term, big_integer const& base) {
+    return big_integer_sum<big_integer_product>{base, term, false};
+}
+
+big_integer_sum<big_integer_product> operator-(big_integer const& base, big_integer_product const& term) {
+    return big_integer_sum<big_integer_product>{base, term, true};
+}
+
+big_integer operator+(big_integer&& base, big_integer_product const& term) {
+    big_integer_expr::accumulate(base, term, false);
+    return std::move(base);
+}
+
+big_integer operator+(big_integer_product const& term, big_integer&& base) {
+    big_integer_expr::accumulate(base, term, false);
+    return std::move(base);
+}
+
+big_integer operator-(big_integer&& base, big_integer_product const& term) {
+    big_integer_expr::accumulate(base, term, true);
+    return std::move(base);
+}
+
+big_integer operator+(big_integer_product const& x, big_integer_product const& y) {
+    big_integer r = x;
+    return r += y;
+}
+
+big_integer operator-(big_integer_product const& x, big_integer_product const& y) {
+    big_integer r = x;
+    return r -= y;
+}
+
+big_integer& operator+=(big_integer& r, big_integer_product const& term) {
+    big_integer_expr::accumulate(r, term, false);
+    return r;
+}
+
+big_integer& operator-=(big_integer& r, big_integer_product const& term) {
+    big_integer_expr::accumulate(r, term, true);
+    return r;
+}
+
+big_integer_sum<big_integer_shifted> operator+(big_integer const& base, big_integer_shifted const& term) {
+    return big_integer_sum<big_integer_shifted>{base, term, false};
+}
+
+big_integer_sum<big_integer_shifted> operator+(big_integer_shifted const& term, big_integer const& base) {
+    return big_integer_sum<big_integer_shifted>{base, term, false};
+}
+
+big_integer_sum<big_integer_shifted> operator-(big_integer const& base, big_integer_shifted const& term) {
+    return big_integer_sum<big_integer_shifted>{base, term, true};
+}
+
+big_integer operator+(big_integer&& base, big_integer_shifted const& term) {
+    big_integer_expr::accumulate(base, term, false);
+    return std::move(base);
+}
+
+big_integer operator+(big_integer_shifted const& term, big_integer&& base) {
+    big_integer_expr::accumulate(base, term, false);
+    return std::move(base);
+}
+
+big_integer operator-(big_integer&& base, big_integer_shifted const& term) {
+    big_integer_expr::accumulate(base, term, true);
+    return std::move(base);
+}
+
+big_integer& operator+=(big_integer& r, big_integer_shifted const& term) {
+    big_integer_expr::accumulate(r, term, false);
+    return r;
+}
+
+big_integer& operator-=(big_integer& r, big_integer_shifted const& term) {
+    big_integer_expr::accumulate(r, term, true);
+    return r;
+}
@@ -0,0 +1,77 @@
+#ifndef BIG_INTEGER_EXPR_H
+#define BIG_INTEGER_EXPR_H
+
+#include "big_integer.h"
+
+// Ленивые выражения, подключаются отдельно. lazy(a) * b и lazy(a) << k сразу ничего не считают,
+// а вычисляются вместе с последующим сложением или вычитанием прямо в результат:
+//     r = c + lazy(a) * b;    r = lazy(a) * b + lazy(c) * d;    r -= lazy(b) * q;    r += lazy(a) << k;
+// Выражения хранят ссылки на операнды и должны использоваться в том же полном выражении.
+// Временное число слева или справа от слагаемого само становится результатом: (c + d) + lazy(a) * b.
+
+struct big_integer_lazy {
+    big_integer const& value;
+};
+
+struct big_integer_product {
+    big_integer const& a;
+    big_integer const& b;
+
+    operator big_integer() const;
+};
+
+struct big_integer_shifted {
+    big_integer const& a;
+    unsigned shift;
+
+    operator big_integer() const;
+};
+
+// base + term или base - term
+template <typename Term>
+struct big_integer_sum {
+    big_integer const& base;
+    Term term;
+    bool subtract;
+
+    operator big_integer() const;
+};
+
+// вычисление слагаемых через внутренние операции big_integer
+struct big_integer_expr {
+    static void accumulate(big_integer& r, big_integer_product const& term, bool subtract);
+    static void accumulate(big_integer& r, big_integer_shifted const& term, bool subtract);
+};
+
+template <typename Term>
+big_integer_sum<Term>::operator big_integer() const {
+    big_integer r = base;
+    big_integer_expr::accumulate(r, term, subtract);
+    return r;
+}
+
+big_integer_lazy lazy(big_integer const&);
+big_integer_product operator*(big_integer_lazy, big_integer const&);
+big_integer_shifted operator<<(big_integer_lazy, unsigned);
+
+big_integer_sum<big_integer_product> operator+(big_integer const&, big_integer_product const&);
+big_integer_sum<big_integer_product> operator+(big_integer_product const&, big_integer const&);
+big_integer_sum<big_integer_product> operator-(big_integer const&, big_integer_product const&);
+big_integer operator+(big_integer&&, big_integer_product const&);
+big_integer operator+(big_integer_product const&, big_integer&&);
+big_integer operator-(big_integer&&, big_integer_product const&);
+big_integer operator+(big_integer_product const&, big_integer_product const&);
+big_integer operator-(big_integer_product const&, big_integer_product const&);
+big_integer& operator+=(big_integer&, big_integer_product const&);
+big_integer& operator-=(big_integer&, big_integer_product const&);
+
+big_integer_sum<big_integer_shifted> operator+(big_integer const&, big_integer_shifted const&);
+big_integer_sum<big_integer_shifted> operator+(big_integer_shifted const&, big_integer const&);
+big_integer_sum<big_integer_shifted> operator-(big_integer const&, big_integer_shifted const&);
+big_integer operator+(big_integer&&, big_integer_shifted const&);
+big_integer operator+(big_integer_shifted const&, big_integer&&);
+big_integer operator-(big_integer&&, big_integer_shifted const&);
+big_integer& operator+=(big_integer&, big_integer_shifted const&);
+big_integer& operator-=(big_integer&, big_integer_shifted const&);
+
+#endif // BIG_INTEGER_EXPR_H
@@ -0,0 +1,158 @@
+#include "big_integer_serialization.h"
+#include <cstring>
+#include <stdexcept>
+
+static unsigned char const MAGIC[4] = {'B', 'G', 'I', 0};
+static uint16_t const VERSION = 1;
+static size_t const HEADER_SIZE = 16;
+static unsigned char const NEGATIVE_FLAG = 1;
+
+static bool isLittleEndianHost() {
+    uint32_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+static void storeLittleEndian(unsigned char* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+static uint64_t loadLittleEndian(unsigned char const* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = bytes; i > 0; --i) {
+        value = (value << 8u) | in[i - 1];
+    }
+    return value;
+}
+
+// цифры big_integer хранятся в формате 32-битными словами, младшие первыми
+static size_t const WORDS_PER_DIGIT = sizeof(digit_t) / 4;
+
+static bool isAligned(unsigned char const* p, size_t alignment) {
+    return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+}
+
+// на little endian платформе младшие words слов цифр -- это просто их байты
+static void storeWords(unsigned char* out, digit_t const* digits, size_t words) {
+    if (isLittleEndianHost()) {
+        std::memcpy(out, digits, 4 * words);
+        return;
+    }
+    for (size_t i = 0; i < words; ++i) {
+        storeLittleEndian(out + 4 * i, digits[i / WORDS_PER_DIGIT] >> (32 * (i % WORDS_PER_DIGIT)), 4);
+    }
+}
+
+// digits должен быть заполнен нулями
+static void loadWords(digit_t* digits, unsigned char const* in, size_t words) {
+    if (isLittleEndianHost()) {
+        std::memcpy(digits, in, 4 * words);
+        return;
+    }
+    for (size_t i = 0; i < words; ++i) {
+        digits[i / WORDS_PER_DIGIT] |= static_cast<digit_t>(loadLittleEndian(in + 4 * i, 4))
+                << (32 * (i % WORDS_PER_DIGIT));
+    }
+}
+
+// проверяет заголовок и возвращает количество слов
+static size_t parseHeader(unsigned char const* in, size_t size, bool& negative) {
+    if (size < HEADER_SIZE || std::memcmp(in, MAGIC, 4) != 0
+            || loadLittleEndian(in + 4, 2) != VERSION || (in[6] & ~NEGATIVE_FLAG) != 0 || in[7] != 0) {
+        throw std::invalid_argument("Invalid serialized big_integer");
+    }
+    uint64_t n = loadLittleEndian(in + 8, 8);
+    if (n != (size - HEADER_SIZE) / 4 || (size - HEADER_SIZE) % 4 != 0) {
+        throw std::invalid_argument("Invalid serialized big_integer");
+    }
+    negative = (in[6] & NEGATIVE_FLAG) != 0;
+    return static_cast<size_t>(n);
+}
+
+// количество слов модуля: у старшей цифры старшие слова могут быть нулевыми
+static size_t absWords(size_t n, digit_t top) {
+    if (n == 0) {
+        return 0;
+    }
+    size_t words = n * WORDS_PER_DIGIT;
+    while (words > (n - 1) * WORDS_PER_DIGIT + 1 && (top >> (32 * ((words - 1) % WORDS_PER_DIGIT))) == 0) {
+        --words;
+    }
+    return words;
+}
+
+size_t serializedSize(big_integer const& a) {
+    return HEADER_SIZE + 4 * absWords(a.absSize(), a.absTopDigit());
+}
+
+void serialize(big_integer const& a, unsigned char* out) {
+    size_t n = a.absSize();
+    size_t words = absWords(n, a.absTopDigit());
+    std::memcpy(out, MAGIC, 4);
+    storeLittleEndian(out + 4, VERSION, 2);
+    out[6] = (a.isPositive() ? 0 : NEGATIVE_FLAG);
+    out[7] = 0;
+    storeLittleEndian(out + 8, words, 8);
+    unsigned char* body = out + HEADER_SIZE;
+    // в выровненный буфер на little endian платформе модуль пишется сразу
+    if (isLittleEndianHost() && isAligned(body, alignof(digit_t)) && words == n * WORDS_PER_DIGIT) {
+        a.copyAbsDigits(reinterpret_cast<digit_t*>(body));
+    } else {
+        std::vector<digit_t> digits(n);
+        a.copyAbsDigits(digits.data());
+        storeWords(body, digits.data(), words);
+    }
+}
+
+std::vector<unsigned char> serialize(big_integer const& a) {
+    std::vector<unsigned char> result(serializedSize(a));
+    serialize(a, result.data());
+    return result;
+}
+
+big_integer deserialize(unsigned char const* in, size_t size) {
+    bool negative;
+    size_t words = parseHeader(in, size, negative);
+    size_t n = (words + WORDS_PER_DIGIT - 1) / WORDS_PER_DIGIT;
+    unsigned char const* body = in + HEADER_SIZE;
+    if (isLittleEndianHost() && isAligned(body, alignof(digit_t)) && words % WORDS_PER_DIGIT == 0) {
+        return big_integer::fromAbsDigits(reinterpret_cast<digit_t const*>(body), n, negative);
+    }
+    std::vector<digit_t> digits(n);
+    loadWords(digits.data(), body, words);
+    return big_integer::fromAbsDigits(digits.data(), n, negative);
+}
+
+big_integer_view::big_integer_view(void const* data, size_t size)
+        : data_(static_cast<unsigned char const*>(data)),
+          size_(0),
+          negative_(false) {
+    size_ = parseHeader(data_, size, negative_);
+}
+
+bool big_integer_view::isNegative() const {
+    return negative_;
+}
+
+size_t big_integer_view::size() const {
+    return size_;
+}
+
+uint32_t big_integer_view::digit(size_t i) const {
+    return static_cast<uint32_t>(loadLittleEndian(data_ + HEADER_SIZE + 4 * i, 4));
+}
+
+uint32_t const* big_integer_view::digits() const {
+    unsigned char const* begin = data_ + HEADER_SIZE;
+    if (!isLittleEndianHost() || !isAligned(begin, alignof(uint32_t))) {
+        return nullptr;
+    }
+    return reinterpret_cast<uint32_t const*>(begin);
+}
+
+big_integer big_integer_view::toBigInteger() const {
+    return deserialize(data_, HEADER_SIZE + 4 * size_);
+}
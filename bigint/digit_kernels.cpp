@@ -0,0 +1,1017 @@
+#include "digit_kernels.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+size_t kernel_thresholds::karatsuba = 32;
+size_t kernel_thresholds::toom3 = 128;
+size_t kernel_thresholds::ntt = 20000;
+size_t kernel_thresholds::burnikelZiegler = 80;
+size_t kernel_thresholds::newton = 150000;
+
+#ifdef BIGINT_X86_64_ASM
+// ядра из digit_kernels_x86_64.S над 64-битными словами; в слове WORD_DIGITS цифр,
+// оставшиеся n % WORD_DIGITS цифр досчитываются циклами ниже
+extern "C" {
+uint64_t bigint_add_n(uint64_t* r, uint64_t const* a, uint64_t const* b, size_t n);
+uint64_t bigint_sub_n(uint64_t* r, uint64_t const* a, uint64_t const* b, size_t n);
+uint64_t bigint_mul_1(uint64_t* r, uint64_t const* a, size_t n, uint64_t d);
+uint64_t bigint_addmul_1(uint64_t* r, uint64_t const* a, size_t n, uint64_t d);
+uint64_t bigint_submul_1(uint64_t* r, uint64_t const* a, size_t n, uint64_t d);
+}
+
+static size_t const WORD_DIGITS = sizeof(uint64_t) / sizeof(digit_t);
+
+static uint64_t* words(digit_t* p) {
+    return reinterpret_cast<uint64_t*>(p);
+}
+
+static uint64_t const* words(digit_t const* p) {
+    return reinterpret_cast<uint64_t const*>(p);
+}
+
+// умножения используют mulx, adcx и adox
+static bool hasMulxAdx() {
+    static bool const supported = (__builtin_cpu_init(), __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("adx"));
+    return supported;
+}
+#endif
+
+// r[0, n) += a[0, n), возвращает перенос
+static digit_t addInPlace(digit_t* r, digit_t const* a, size_t n) {
+    size_t i = 0;
+    double_digit_t carry = 0;
+#ifdef BIGINT_X86_64_ASM
+    i = n - n % WORD_DIGITS;
+    carry = bigint_add_n(words(r), words(r), words(a), i / WORD_DIGITS);
+#endif
+    for (; i < n; ++i) {
+        carry += static_cast<double_digit_t>(r[i]) + a[i];
+        r[i] = static_cast<digit_t>(carry);
+        carry >>= DIGIT_BITS;
+    }
+    return static_cast<digit_t>(carry);
+}
+
+// r[0, n) = a[0, n) - r[0, n), возвращает заём
+static digit_t reverseSubInPlace(digit_t* r, digit_t const* a, size_t n) {
+    size_t i = 0;
+    digit_t borrow = 0;
+#ifdef BIGINT_X86_64_ASM
+    i = n - n % WORD_DIGITS;
+    borrow = static_cast<digit_t>(bigint_sub_n(words(r), words(a), words(r), i / WORD_DIGITS));
+#endif
+    for (; i < n; ++i) {
+        double_digit_t cur = static_cast<double_digit_t>(a[i]) - r[i] - borrow;
+        r[i] = static_cast<digit_t>(cur);
+        borrow = static_cast<digit_t>(cur >> (2 * DIGIT_BITS - 1));
+    }
+    return borrow;
+}
+
+// r[0, n) -= a[0, n), возвращает заём
+static digit_t subInPlace(digit_t* r, digit_t const* a, size_t n) {
+    size_t i = 0;
+    digit_t borrow = 0;
+#ifdef BIGINT_X86_64_ASM
+    i = n - n % WORD_DIGITS;
+    borrow = static_cast<digit_t>(bigint_sub_n(words(r), words(r), words(a), i / WORD_DIGITS));
+#endif
+    for (; i < n; ++i) {
+        double_digit_t cur = static_cast<double_digit_t>(r[i]) - a[i] - borrow;
+        r[i] = static_cast<digit_t>(cur);
+        borrow = static_cast<digit_t>(cur >> (2 * DIGIT_BITS - 1));
+    }
+    return borrow;
+}
+
+// r[0, n) += carry, возвращает перенос из старшей цифры
+static digit_t propagateCarry(digit_t* r, size_t n, digit_t carry) {
+    for (size_t i = 0; carry != 0 && i < n; ++i) {
+        r[i] += carry;
+        carry = (r[i] < carry ? 1 : 0);
+    }
+    return carry;
+}
+
+// r[0, n) -= borrow, возвращает заём из старшей цифры
+static digit_t propagateBorrow(digit_t* r, size_t n, digit_t borrow) {
+    for (size_t i = 0; borrow != 0 && i < n; ++i) {
+        borrow = (r[i] == 0 ? 1 : 0);
+        --r[i];
+    }
+    return borrow;
+}
+
+// r[0, n) += a[0, m) при m <= n
+static digit_t addLong(digit_t* r, size_t n, digit_t const* a, size_t m) {
+    return propagateCarry(r + m, n - m, addInPlace(r, a, m));
+}
+
+// r[0, n) -= a[0, m) при m <= n
+static digit_t subLong(digit_t* r, size_t n, digit_t const* a, size_t m) {
+    return propagateBorrow(r + m, n - m, subInPlace(r, a, m));
+}
+
+// r[0, n) = a[0, n) * d, возвращает перенос
+static digit_t mulDigit(digit_t* r, digit_t const* a, size_t n, digit_t d) {
+    size_t i = 0;
+    double_digit_t carry = 0;
+#ifdef BIGINT_X86_64_ASM
+    if (hasMulxAdx()) {
+        i = n - n % WORD_DIGITS;
+        carry = bigint_mul_1(words(r), words(a), i / WORD_DIGITS, d);
+    }
+#endif
+    for (; i < n; ++i) {
+        carry += static_cast<double_digit_t>(a[i]) * d;
+        r[i] = static_cast<digit_t>(carry);
+        carry >>= DIGIT_BITS;
+    }
+    return static_cast<digit_t>(carry);
+}
+
+// r[0, n) += a[0, n) * d, возвращает перенос
+static digit_t addMulDigit(digit_t* r, digit_t const* a, size_t n, digit_t d) {
+    size_t i = 0;
+    double_digit_t carry = 0;
+#ifdef BIGINT_X86_64_ASM
+    if (hasMulxAdx()) {
+        i = n - n % WORD_DIGITS;
+        carry = bigint_addmul_1(words(r), words(a), i / WORD_DIGITS, d);
+    }
+#endif
+    for (; i < n; ++i) {
+        carry += static_cast<double_digit_t>(a[i]) * d + r[i];
+        r[i] = static_cast<digit_t>(carry);
+        carry >>= DIGIT_BITS;
+    }
+    return static_cast<digit_t>(carry);
+}
+
+// r[0, n) -= a[0, n) * d, возвращает заём
+static digit_t subMulDigit(digit_t* r, digit_t const* a, size_t n, digit_t d) {
+    size_t i = 0;
+    double_digit_t carry = 0;
+#ifdef BIGINT_X86_64_ASM
+    if (hasMulxAdx()) {
+        i = n - n % WORD_DIGITS;
+        carry = bigint_submul_1(words(r), words(a), i / WORD_DIGITS, d);
+    }
+#endif
+    for (; i < n; ++i) {
+        carry += static_cast<double_digit_t>(a[i]) * d;
+        digit_t cur = r[i] - static_cast<digit_t>(carry);
+        carry = (carry >> DIGIT_BITS) + (cur > r[i] ? 1 : 0);
+        r[i] = cur;
+    }
+    return static_cast<digit_t>(carry);
+}
+
+// r[0, n) = a[0, n) << shift при shift < 32, возвращает выдвинутые биты
+static digit_t shiftLeftDigits(digit_t* r, digit_t const* a, size_t n, unsigned shift) {
+    if (shift == 0) {
+        std::copy_n(a, n, r);
+        return 0;
+    }
+    digit_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        digit_t next = a[i] >> (DIGIT_BITS - shift);
+        r[i] = (a[i] << shift) | carry;
+        carry = next;
+    }
+    return carry;
+}
+
+// r[0, n) = a[0, n + 1) >> shift при shift < 32
+static void shiftRightDigits(digit_t* r, digit_t const* a, size_t n, unsigned shift) {
+    if (shift == 0) {
+        std::copy_n(a, n, r);
+        return;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        r[i] = (a[i] >> shift) | (a[i + 1] << (DIGIT_BITS - shift));
+    }
+}
+
+static unsigned leadingZeros(digit_t d) {
+    unsigned count = 0;
+    for (; (d & (static_cast<digit_t>(1) << (DIGIT_BITS - 1))) == 0; d <<= 1u) {
+        ++count;
+    }
+    return count;
+}
+
+// r[0, n) >>= 1
+static void shiftRightOneInPlace(digit_t* r, size_t n) {
+    for (size_t i = 0; i + 1 < n; ++i) {
+        r[i] = (r[i] >> 1u) | (r[i + 1] << (DIGIT_BITS - 1));
+    }
+    r[n - 1] >>= 1u;
+}
+
+// r[0, n) <<= 1, возвращает выдвинутый бит
+static digit_t shiftLeftOneInPlace(digit_t* r, size_t n) {
+    digit_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        digit_t next = r[i] >> (DIGIT_BITS - 1);
+        r[i] = (r[i] << 1u) | carry;
+        carry = next;
+    }
+    return carry;
+}
+
+// r[0, n) /= 3, деление обязано быть нацело
+static void divExactByThreeInPlace(digit_t* r, size_t n) {
+    digit_t const inverse = DIGIT_MAX / 3 * 2 + 1;     // 3 * inverse == 1 (mod 2^DIGIT_BITS)
+    digit_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        digit_t cur = r[i] - carry;
+        carry = (cur > r[i] ? 1 : 0);
+        r[i] = cur * inverse;
+        carry += static_cast<digit_t>((static_cast<double_digit_t>(r[i]) * 3) >> DIGIT_BITS);
+    }
+}
+
+static int cmpVectors(digit_t const* a, digit_t const* b, size_t n) {
+    for (size_t i = n; i > 0; --i) {
+        if (a[i - 1] != b[i - 1]) {
+            return (a[i - 1] < b[i - 1] ? -1 : 1);
+        }
+    }
+    return 0;
+}
+
+// r[0, n) = |a[0, n) - b[0, m)| при m <= n, возвращает a < b
+static bool absDiff(digit_t* r, digit_t const* a, size_t n, digit_t const* b, size_t m) {
+    bool less = std::all_of(a + m, a + n, [](digit_t d) { return d == 0; }) &&
+                cmpVectors(a, b, m) < 0;
+    if (less) {
+        std::copy_n(b, m, r);
+        std::fill(r + m, r + n, 0u);
+        subInPlace(r, a, m);
+    } else {
+        std::copy_n(a, n, r);
+        subLong(r, n, b, m);
+    }
+    return less;
+}
+
+static void mulSchoolbook(digit_t* r, digit_t const* a, size_t n, digit_t const* b, size_t m) {
+    if (m == 0) {
+        std::fill(r, r + n, 0u);
+        return;
+    }
+    r[n] = mulDigit(r, a, n, b[0]);
+    for (size_t j = 1; j < m; ++j) {
+        r[j + n] = addMulDigit(r + j, a, n, b[j]);
+    }
+}
+
+// r[0, 2n) = a[0, n)^2, каждое попарное произведение считается один раз
+static void sqrSchoolbook(digit_t* r, digit_t const* a, size_t n) {
+    std::fill(r, r + 2 * n, 0u);
+    for (size_t i = 0; i + 1 < n; ++i) {
+        r[i + n] = addMulDigit(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+    }
+    shiftLeftOneInPlace(r, 2 * n);
+    double_digit_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double_digit_t square = static_cast<double_digit_t>(a[i]) * a[i];
+        carry += static_cast<double_digit_t>(r[2 * i]) + static_cast<digit_t>(square);
+        r[2 * i] = static_cast<digit_t>(carry);
+        carry >>= DIGIT_BITS;
+        carry += static_cast<double_digit_t>(r[2 * i + 1]) + (square >> DIGIT_BITS);
+        r[2 * i + 1] = static_cast<digit_t>(carry);
+        carry >>= DIGIT_BITS;
+    }
+}
+
+static void mulSchoolbookOrSqr(digit_t* r, digit_t const* a, size_t n, digit_t const* b, size_t m) {
+    if (a == b && n == m) {
+        sqrSchoolbook(r, a, n);
+    } else {
+        mulSchoolbook(r, a, n, b, m);
+    }
+}
+
+static size_t karatsubaThreshold() {
+    return std::max<size_t>(kernel_thresholds::karatsuba, 2);
+}
+
+static size_t toom3Threshold() {
+    return std::max<size_t>(kernel_thresholds::toom3, 5);
+}
+
+// Умножение через теоретико-числовое преобразование по трём простым модулям.
+// Произведение модулей больше 2^85, поэтому коэффициент свёртки однозначно восстанавливается
+// по китайской теореме об остатках, пока он меньше 2^85: коэффициентами служат 32-битные половины
+// цифр (или цифры целиком при 32-битных цифрах), если меньший операнд не длиннее 2^21 таких половин,
+// иначе -- куски по 16 бит.
+template<uint32_t MOD, uint32_t ROOT>
+struct ntt_field {
+    static const uint32_t modulo = MOD;
+
+    static uint32_t mul(uint32_t a, uint32_t b) {
+        return static_cast<uint32_t>(static_cast<uint64_t>(a) * b % MOD);
+    }
+
+    static uint32_t pow(uint32_t a, uint64_t e) {
+        uint32_t result = 1;
+        for (; e > 0; e >>= 1u) {
+            if (e & 1u) {
+                result = mul(result, a);
+            }
+            a = mul(a, a);
+        }
+        return result;
+    }
+
+    static uint32_t inverse(uint32_t a) {
+        return pow(a, MOD - 2);
+    }
+
+    static void transform(uint32_t* a, size_t len, bool inverted) {
+        for (size_t i = 1, j = 0; i < len; ++i) {
+            size_t bit = len >> 1u;
+            for (; j & bit; bit >>= 1u) {
+                j ^= bit;
+            }
+            j ^= bit;
+            if (i < j) {
+                std::swap(a[i], a[j]);
+            }
+        }
+        // roots[half + j] -- степени первообразного корня степени 2 * half
+        std::vector<uint32_t> roots(std::max<size_t>(len, 2));
+        for (size_t half = 1; half < len; half <<= 1u) {
+            uint32_t root = pow(ROOT, (MOD - 1) / (2 * half));
+            if (inverted) {
+                root = inverse(root);
+            }
+            roots[half] = 1;
+            for (size_t j = 1; j < half; ++j) {
+                roots[half + j] = mul(roots[half + j - 1], root);
+            }
+        }
+        for (size_t half = 1; half < len; half <<= 1u) {
+            uint32_t const* w = roots.data() + half;
+            for (size_t i = 0; i < len; i += 2 * half) {
+                for (size_t j = 0; j < half; ++j) {
+                    uint32_t u = a[i + j];
+                    uint32_t v = mul(a[i + j + half], w[j]);
+                    a[i + j] = (u + v >= MOD ? u + v - MOD : u + v);
+                    a[i + j + half] = (u >= v ? u - v : u + MOD - v);
+                }
+            }
+        }
+        if (inverted) {
+            uint32_t factor = inverse(static_cast<uint32_t>(len % MOD));
+            for (size_t i = 0; i < len; ++i) {
+                a[i] = mul(a[i], factor);
+            }
+        }
+    }
+};
+
+using ntt_field1 = ntt_field<754974721u, 11u>;     // 45 * 2^24 + 1
+using ntt_field2 = ntt_field<167772161u, 3u>;      // 5 * 2^25 + 1
+using ntt_field3 = ntt_field<469762049u, 3u>;      // 7 * 2^26 + 1
+
+static size_t const NTT_MAX_LENGTH = static_cast<size_t>(1) << 24u;
+static size_t const NTT_MAX_WORDS = static_cast<size_t>(1) << 21u;
+
+// сколько коэффициентов приходится на одну цифру
+static size_t nttSplit(size_t n, size_t m) {
+    size_t words = DIGIT_BITS / 32;
+    return (std::min(n, m) * words <= NTT_MAX_WORDS ? words : 2 * words);
+}
+
+static bool nttFits(size_t n, size_t m) {
+    return nttSplit(n, m) * (n + m) <= NTT_MAX_LENGTH;
+}
+
+static void splitToCoefficients(uint32_t* f, size_t len, digit_t const* a, size_t n,
+                                size_t split, uint32_t modulo) {
+    unsigned const bits = static_cast<unsigned>(DIGIT_BITS / split);
+    digit_t const mask = DIGIT_MAX >> (DIGIT_BITS - bits);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < split; ++j) {
+            f[split * i + j] = static_cast<uint32_t>((a[i] >> (bits * j)) & mask) % modulo;
+        }
+    }
+    std::fill(f + split * n, f + len, 0u);
+}
+
+// fa = a * b по модулю field::modulo, для квадрата прямое преобразование делается одно
+template<typename field>
+static void nttConvolve(uint32_t* fa, uint32_t* fb, size_t len, size_t split,
+                        digit_t const* a, size_t n, digit_t const* b, size_t m) {
+    splitToCoefficients(fa, len, a, n, split, field::modulo);
+    field::transform(fa, len, false);
+    if (a == b && n == m) {
+        for (size_t i = 0; i < len; ++i) {
+            fa[i] = field::mul(fa[i], fa[i]);
+        }
+    } else {
+        splitToCoefficients(fb, len, b, m, split, field::modulo);
+        field::transform(fb, len, false);
+        for (size_t i = 0; i < len; ++i) {
+            fa[i] = field::mul(fa[i], fb[i]);
+        }
+    }
+    field::transform(fa, len, true);
+}
+
+// r[0, n + m) = a[0, n) * b[0, m)
+static void mulNtt(digit_t* r, digit_t const* a, size_t n, digit_t const* b, size_t m) {
+    size_t split = nttSplit(n, m);
+    size_t count = split * (n + m);
+    size_t len = 1;
+    while (len < count) {
+        len <<= 1u;
+    }
+    std::vector<uint32_t> buffer(4 * len);
+    uint32_t* f1 = buffer.data();
+    uint32_t* f2 = f1 + len;
+    uint32_t* f3 = f2 + len;
+    uint32_t* fb = f3 + len;
+    nttConvolve<ntt_field1>(f1, fb, len, split, a, n, b, m);
+    nttConvolve<ntt_field2>(f2, fb, len, split, a, n, b, m);
+    nttConvolve<ntt_field3>(f3, fb, len, split, a, n, b, m);
+
+    uint64_t const p1 = ntt_field1::modulo;
+    uint64_t const p2 = ntt_field2::modulo;
+    uint64_t const p3 = ntt_field3::modulo;
+    uint32_t const inv1 = ntt_field2::inverse(static_cast<uint32_t>(p1 % p2));
+    uint32_t const inv12 = ntt_field3::inverse(static_cast<uint32_t>(p1 * p2 % p3));
+    unsigned const bits = static_cast<unsigned>(DIGIT_BITS / split);
+    digit_t const mask = DIGIT_MAX >> (DIGIT_BITS - bits);
+    __extension__ typedef unsigned __int128 uint128_t;
+    uint128_t carry = 0;
+    std::fill(r, r + n + m, 0u);
+    for (size_t i = 0; i < count; ++i) {
+        // x = x1 + p1 * c2 + p1 * p2 * c3 по алгоритму Гарнера
+        uint64_t c2 = ntt_field2::mul(static_cast<uint32_t>((f2[i] + p2 - f1[i] % p2) % p2), inv1);
+        uint64_t x12 = f1[i] + p1 * c2;
+        uint64_t c3 = ntt_field3::mul(static_cast<uint32_t>((f3[i] + p3 - x12 % p3) % p3), inv12);
+        carry += x12 + static_cast<uint128_t>(p1 * p2) * c3;
+        r[i / split] |= (static_cast<digit_t>(carry) & mask) << (bits * (i % split));
+        carry >>= bits;
+    }
+}
+
+static bool useNtt(size_t n, size_t m) {
+    return std::min(n, m) >= std::max<size_t>(kernel_thresholds::ntt, 2) && nttFits(n, m);
+}
+
+// scratch, достаточный для mulBalanced любого размера из [lo, hi]. Потребность не монотонна по размеру
+// (на порогах между методами она падает), поэтому берётся максимум по всем размерам подпроизведений:
+// у соседних размеров они тоже соседние, диапазон остаётся узким
+static size_t mulScratchBound(size_t lo, size_t hi) {
+    size_t own = 0;
+    size_t childLo = hi;
+    size_t childHi = 0;
+    for (size_t n = lo; n <= hi; ++n) {
+        if (n < karatsubaThreshold() || useNtt(n, n)) {
+            continue;
+        } else if (n < toom3Threshold()) {
+            size_t half = n - n / 2;
+            own = std::max(own, 6 * half + 1);
+            childLo = std::min(childLo, n / 2);
+            childHi = std::max(childHi, half);
+        } else {
+            size_t k = (n + 2) / 3;
+            own = std::max(own, 6 * (k + 1) + 3 * (2 * k + 2));
+            childLo = std::min(childLo, n - 2 * k);
+            childHi = std::max(childHi, k + 1);
+        }
+    }
+    return (childHi == 0 ? own : own + mulScratchBound(childLo, childHi));
+}
+
+static size_t mulScratchSize(size_t n) {
+    return mulScratchBound(n, n);
+}
+
+static void mulBalanced(digit_t* r, digit_t const* a, digit_t const* b, size_t n,
+                        digit_t* scratch);
+
+// r[0, 2n) = a[0, n) * b[0, n)
+// a * b = a0b0 + (a0b0 + a1b1 - (a1 - a0)(b1 - b0)) * B^lo + a1b1 * B^(2lo)
+// при a == b все три произведения тоже оказываются квадратами
+static void mulKaratsuba(digit_t* r, digit_t const* a, digit_t const* b, size_t n,
+                         digit_t* scratch) {
+    size_t lo = n / 2;
+    size_t hi = n - lo;
+    digit_t* da = scratch;
+    digit_t* db = da + hi;
+    digit_t* z = db + hi;
+    digit_t* t = z + 2 * hi;
+    digit_t* next = t + 2 * hi + 1;
+
+    mulBalanced(r, a, b, lo, next);
+    mulBalanced(r + 2 * lo, a + lo, b + lo, hi, next);
+    bool negative = absDiff(da, a + lo, hi, a, lo);
+    if (a == b) {
+        db = da;
+        negative = false;
+    } else {
+        negative = (negative != absDiff(db, b + lo, hi, b, lo));
+    }
+    mulBalanced(z, da, db, hi, next);
+
+    std::copy_n(r + 2 * lo, 2 * hi, t);
+    t[2 * hi] = 0;
+    addLong(t, 2 * hi + 1, r, 2 * lo);
+    if (negative) {
+        t[2 * hi] += addInPlace(t, z, 2 * hi);
+    } else {
+        t[2 * hi] -= subInPlace(t, z, 2 * hi);
+    }
+    addLong(r + lo, 2 * n - lo, t, 2 * hi + 1);
+}
+
+// значения a(x) = a0 + a1 * x + a2 * x^2 в точках 1, -1 и 2, куски a0 и a1 по k цифр, a2 -- l цифр
+// возвращает знак a(-1), сами значения записываются по модулю в k + 1 цифру
+static bool evaluateToom3(digit_t* p1, digit_t* pm1, digit_t* p2, digit_t const* a,
+                          size_t k, size_t l) {
+    std::copy_n(a, k, p1);
+    p1[k] = 0;
+    addLong(p1, k + 1, a + 2 * k, l);
+    bool negative = absDiff(pm1, p1, k + 1, a + k, k);
+    p1[k] += addInPlace(p1, a + k, k);
+
+    std::copy_n(a, k, p2);
+    p2[k] = addMulDigit(p2, a + k, k, 2);
+    propagateCarry(p2 + l, k + 1 - l, addMulDigit(p2, a + 2 * k, l, 4));
+    return negative;
+}
+
+// r[0, 2n) = a[0, n) * b[0, n), вычисление в точках 0, 1, -1, 2, бесконечность
+// и интерполяция по схеме Бодрато, все промежуточные значения неотрицательны, кроме v(-1)
+static void mulToom3(digit_t* r, digit_t const* a, digit_t const* b, size_t n,
+                     digit_t* scratch) {
+    size_t k = (n + 2) / 3;
+    size_t l = n - 2 * k;
+    size_t w = 2 * k + 2;
+    digit_t* pa1 = scratch;
+    digit_t* pam1 = pa1 + (k + 1);
+    digit_t* pa2 = pam1 + (k + 1);
+    digit_t* pb1 = pa2 + (k + 1);
+    digit_t* pbm1 = pb1 + (k + 1);
+    digit_t* pb2 = pbm1 + (k + 1);
+    digit_t* v1 = pb2 + (k + 1);
+    digit_t* vm1 = v1 + w;
+    digit_t* v2 = vm1 + w;
+    digit_t* next = v2 + w;
+    digit_t* v0 = r;
+    digit_t* vinf = r + 4 * k;
+
+    bool negative = evaluateToom3(pa1, pam1, pa2, a, k, l);
+    if (a == b) {
+        pb1 = pa1;
+        pbm1 = pam1;
+        pb2 = pa2;
+        negative = false;
+    } else {
+        negative = (negative != evaluateToom3(pb1, pbm1, pb2, b, k, l));
+    }
+    mulBalanced(v0, a, b, k, next);
+    mulBalanced(vinf, a + 2 * k, b + 2 * k, l, next);
+    mulBalanced(v1, pa1, pb1, k + 1, next);
+    mulBalanced(vm1, pam1, pbm1, k + 1, next);
+    mulBalanced(v2, pa2, pb2, k + 1, next);
+
+    // v2 = (v2 - vm1) / 3
+    if (negative) {
+        addInPlace(v2, vm1, w);
+    } else {
+        subInPlace(v2, vm1, w);
+    }
+    divExactByThreeInPlace(v2, w);
+    // vm1 = (v1 - vm1) / 2
+    if (negative) {
+        addInPlace(vm1, v1, w);
+    } else {
+        reverseSubInPlace(vm1, v1, w);
+    }
+    shiftRightOneInPlace(vm1, w);
+    // v1 = v1 - v0, v2 = (v2 - v1) / 2
+    subLong(v1, w, v0, 2 * k);
+    subInPlace(v2, v1, w);
+    shiftRightOneInPlace(v2, w);
+    // v1 = v1 - vm1 - vinf, v2 = v2 - 2 * vinf, vm1 = vm1 - v2
+    subInPlace(v1, vm1, w);
+    subLong(v1, w, vinf, 2 * l);
+    subLong(v2, w, vinf, 2 * l);
+    subLong(v2, w, vinf, 2 * l);
+    subInPlace(vm1, v2, w);
+
+    // коэффициенты: v0, vm1, v1, v2, vinf
+    std::fill(r + 2 * k, r + 4 * k, 0u);
+    addLong(r + k, 2 * n - k, vm1, std::min(w, 2 * n - k));
+    addLong(r + 2 * k, 2 * n - 2 * k, v1, std::min(w, 2 * n - 2 * k));
+    addLong(r + 3 * k, 2 * n - 3 * k, v2, std::min(w, 2 * n - 3 * k));
+}
+
+static void mulBalanced(digit_t* r, digit_t const* a, digit_t const* b, size_t n,
+                        digit_t* scratch) {
+    if (n < karatsubaThreshold()) {
+        mulSchoolbookOrSqr(r, a, n, b, n);
+    } else if (n < toom3Threshold()) {
+        mulKaratsuba(r, a, b, n, scratch);
+    } else if (!useNtt(n, n)) {
+        mulToom3(r, a, b, n, scratch);
+    } else {
+        mulNtt(r, a, n, b, n);
+    }
+}
+
+void mulVectors(digit_t* r, digit_t const* a, size_t n, digit_t const* b, size_t m) {
+    if (n < m) {
+        std::swap(a, b);
+        std::swap(n, m);
+    }
+    if (m < karatsubaThreshold()) {
+        mulSchoolbookOrSqr(r, a, n, b, m);
+        return;
+    }
+    if (useNtt(n, m)) {
+        mulNtt(r, a, n, b, m);
+        return;
+    }
+    if (n == m) {
+        std::vector<digit_t> scratch(mulScratchSize(n));
+        mulBalanced(r, a, b, n, scratch.data());
+        return;
+    }
+    // длинный операнд режем на куски по m цифр, чтобы умножения были сбалансированными
+    std::vector<digit_t> scratch(2 * m + mulScratchSize(m));
+    digit_t* product = scratch.data();
+    std::fill(r, r + n + m, 0u);
+    for (size_t i = 0; i < n; i += m) {
+        size_t len = std::min(m, n - i);
+        if (len == m) {
+            mulBalanced(product, a + i, b, m, product + 2 * m);
+        } else {
+            mulVectors(product, b, m, a + i, len);
+        }
+        addLong(r + i, n + m - i, product, len + m);
+    }
+}
+
+digit_t addMulVectors(digit_t* r, size_t rn, digit_t const* a, size_t n, digit_t const* b, size_t m) {
+    if (n < m) {
+        std::swap(a, b);
+        std::swap(n, m);
+    }
+    if (m < karatsubaThreshold()) {
+        digit_t carry = 0;
+        for (size_t j = 0; j < m; ++j) {
+            carry += propagateCarry(r + j + n, rn - j - n, addMulDigit(r + j, a, n, b[j]));
+        }
+        return carry;
+    }
+    std::vector<digit_t> product(n + m);
+    mulVectors(product.data(), a, n, b, m);
+    return addLong(r, rn, product.data(), n + m);
+}
+
+digit_t subMulVectors(digit_t* r, size_t rn, digit_t const* a, size_t n, digit_t const* b, size_t m) {
+    if (n < m) {
+        std::swap(a, b);
+        std::swap(n, m);
+    }
+    if (m < karatsubaThreshold()) {
+        digit_t borrow = 0;
+        for (size_t j = 0; j < m; ++j) {
+            digit_t rowBorrow = subMulDigit(r + j, a, n, b[j]);
+            digit_t top = r[j + n];
+            r[j + n] = top - rowBorrow;
+            borrow += propagateBorrow(r + j + n + 1, rn - j - n - 1, (top < rowBorrow ? 1 : 0));
+        }
+        return borrow;
+    }
+    std::vector<digit_t> product(n + m);
+    mulVectors(product.data(), a, n, b, m);
+    return subLong(r, rn, product.data(), n + m);
+}
+
+// деление нормализованных чисел (старший бит v равен единице) алгоритмом D Кнута
+// старшие m цифр u должны быть меньше v, частное из uSize - m цифр пишется в q, остаток остаётся в u[0, m)
+static void divSchoolbook(digit_t* q, digit_t* u, size_t uSize, digit_t const* v, size_t m) {
+    double_digit_t const base = static_cast<double_digit_t>(1) << DIGIT_BITS;
+    for (size_t j = uSize - m; j > 0; --j) {
+        digit_t* window = u + j - 1;
+        double_digit_t top = (static_cast<double_digit_t>(window[m]) << DIGIT_BITS) | window[m - 1];
+        double_digit_t qhat = top / v[m - 1];
+        double_digit_t rhat = top % v[m - 1];
+        while (qhat >= base || qhat * v[m - 2] > ((rhat << DIGIT_BITS) | window[m - 2])) {
+            --qhat;
+            rhat += v[m - 1];
+            if (rhat >= base) {
+                break;
+            }
+        }
+        digit_t borrow = subMulDigit(window, v, m, static_cast<digit_t>(qhat));
+        if (window[m] < borrow) {   // оценка оказалась на единицу больше
+            --qhat;
+            window[m] += addInPlace(window, v, m);
+        }
+        window[m] -= borrow;
+        q[j - 1] = static_cast<digit_t>(qhat);
+    }
+}
+
+static size_t burnikelZieglerThreshold() {
+    return std::max<size_t>(kernel_thresholds::burnikelZiegler, 4);
+}
+
+static void div2n1n(digit_t* q, digit_t* a, digit_t const* b, size_t n, digit_t* scratch);
+
+// q[0, k) = a[0, 3k) / b[0, 2k), остаток в a[0, 2k), a[2k, 3k) обнуляется; старшие 2k цифр a меньше b
+static void div3n2n(digit_t* q, digit_t* a, digit_t const* b, size_t k, digit_t* scratch) {
+    digit_t* d = scratch;
+    digit_t* next = d + 2 * k;
+    if (cmpVectors(a + 2 * k, b + k, k) < 0) {
+        div2n1n(q, a + k, b + k, k, next);
+    } else {
+        // старшие половины равны, тогда q = B^k - 1 и остаток a[k, 3k) - q * b1 = a[k, 2k) + b1
+        std::fill(q, q + k, DIGIT_MAX);
+        std::fill(a + 2 * k, a + 3 * k, 0u);
+        a[2 * k] = addInPlace(a + k, b + k, k);
+    }
+    // вычитаем q * b2, пока остаток отрицателен, возвращаем делитель (не больше двух раз)
+    mulVectors(d, q, k, b, k);
+    digit_t borrow = subLong(a, 2 * k + 1, d, 2 * k);
+    while (borrow != 0) {
+        borrow -= addLong(a, 2 * k + 1, b, 2 * k);
+        propagateBorrow(q, k, 1);
+    }
+    a[2 * k] = 0;
+}
+
+// q[0, n) = a[0, 2n) / b[0, n), остаток в a[0, n), a[n, 2n) обнуляется; старшие n цифр a меньше b
+static void div2n1n(digit_t* q, digit_t* a, digit_t const* b, size_t n, digit_t* scratch) {
+    if (n % 2 != 0 || n < burnikelZieglerThreshold()) {
+        divSchoolbook(q, a, 2 * n, b, n);
+        return;
+    }
+    size_t k = n / 2;
+    div3n2n(q + k, a + k, b, k, scratch);
+    div3n2n(q, a, b, k, scratch);
+}
+
+static size_t newtonThreshold() {
+    return std::max<size_t>(kernel_thresholds::newton, 4);
+}
+
+// x[0, k + 1) ~ B^2k / d[0, k) с ошибкой в несколько единиц, d нормализовано
+// приближение для старших h > k / 2 цифр уточняется одним шагом Ньютона x += x * (B^2k - d * x) / B^2k
+static void invertApprox(digit_t* x, digit_t const* d, size_t k) {
+    // обратное к половине делителя всё ещё выгоднее уточнять, поэтому база рекурсии ниже порога
+    if (k < std::max<size_t>(newtonThreshold() / 32, 4)) {
+        std::vector<digit_t> ones(2 * k, DIGIT_MAX);
+        divRemVectors(x, nullptr, ones.data(), 2 * k, d, k);
+        return;
+    }
+    size_t h = k / 2 + 1;
+    std::vector<digit_t> buffer((h + 1) + (2 * k + 1) + (2 * k + h + 2));
+    digit_t* xh = buffer.data();
+    digit_t* e = xh + h + 1;
+    digit_t* product = e + 2 * k + 1;
+    invertApprox(xh, d + k - h, h);
+    std::fill(x, x + k - h, 0u);
+    std::copy_n(xh, h + 1, x + k - h);
+
+    // e = |B^2k - d * x|, где x = xh * B^(k - h)
+    std::fill(e, e + k - h, 0u);
+    mulVectors(e + k - h, d, k, xh, h + 1);
+    bool below = (e[2 * k] == 0);
+    if (below) {
+        for (size_t i = 0; i < 2 * k; ++i) {
+            e[i] = ~e[i];
+        }
+        propagateCarry(e, 2 * k, 1);
+    } else {
+        --e[2 * k];
+    }
+    size_t eSize = 2 * k + 1;
+    while (eSize > 0 && e[eSize - 1] == 0) {
+        --eSize;
+    }
+    if (eSize + h + 1 <= k + h) {
+        return;
+    }
+    // поправка x * e / B^2k = xh * e / B^(k + h)
+    mulVectors(product, xh, h + 1, e, eSize);
+    size_t correction = std::min(eSize + 1 - k, k + 1);
+    if (below) {
+        addLong(x, k + 1, product + k + h, correction);
+    } else {
+        subLong(x, k + 1, product + k + h, correction);
+    }
+}
+
+// то же, что divSchoolbook, но частное по блокам из s <= m цифр оценивается умножением
+// старших цифр блока на приближение обратного к старшим min(m, s + 1) цифрам делителя,
+// после чего оценка исправляется по остатку на несколько единиц
+static void divNewton(digit_t* q, digit_t* u, size_t uSize, digit_t const* v, size_t m) {
+    std::vector<digit_t> x;
+    std::vector<digit_t> buffer(4 * m + 2);
+    digit_t* estimate = buffer.data();
+    digit_t* product = estimate + 2 * m + 2;
+    size_t xPrecision = 0;
+    for (size_t j = uSize - m; j > 0;) {
+        size_t s = std::min(m, j);
+        size_t k = std::min(m, s + 1);
+        if (k != xPrecision) {
+            x.assign(k + 1, 0u);
+            invertApprox(x.data(), v + m - k, k);
+            xPrecision = k;
+        }
+        j -= s;
+        digit_t* window = u + j;
+        digit_t* qb = q + j;
+
+        // qb ~ window * x / B^(m + k), от обоих множителей берутся только старшие t > s цифр,
+        // отброшенные цифры меняют оценку не больше чем на единицу; оценка не больше B^s - 1
+        size_t t = std::min(s + 2, k + 1);
+        mulVectors(estimate, window + m + s - t, t, x.data() + k + 1 - t, t);
+        if (estimate[2 * t - 1] != 0) {
+            std::fill(qb, qb + s, DIGIT_MAX);
+        } else {
+            std::copy_n(estimate + 2 * t - s - 1, s, qb);
+        }
+        mulVectors(product, qb, s, v, m);
+        digit_t borrow = subLong(window, m + s, product, m + s);
+        while (borrow != 0) {
+            borrow -= addLong(window, m + s, v, m);
+            propagateBorrow(qb, s, 1);
+        }
+        while (std::any_of(window + m, window + m + s, [](digit_t d) { return d != 0; })
+                || cmpVectors(window, v, m) >= 0) {
+            subLong(window, m + s, v, m);
+            propagateCarry(qb, s, 1);
+        }
+    }
+}
+
+void divRemVectors(digit_t* q, digit_t* r, digit_t const* u, size_t n, digit_t const* v, size_t m) {
+    // нормализуем делитель, чтобы старший бит был единицей, тогда оценка частного
+    // по двум старшим цифрам ошибается не больше чем на единицу
+    unsigned shift = leadingZeros(v[m - 1]);
+    bool newton = (m >= newtonThreshold() && n - m >= newtonThreshold());
+    if (newton || m < burnikelZieglerThreshold() || n - m < burnikelZieglerThreshold()) {
+        std::vector<digit_t> buffer(n + 1 + m);
+        digit_t* un = buffer.data();
+        digit_t* vn = un + n + 1;
+        shiftLeftDigits(vn, v, m, shift);
+        un[n] = shiftLeftDigits(un, u, n, shift);
+        if (newton) {
+            divNewton(q, un, n + 1, vn, m);
+        } else {
+            divSchoolbook(q, un, n + 1, vn, m);
+        }
+        if (r != nullptr) {
+            shiftRightDigits(r, un, m, shift);
+        }
+        return;
+    }
+
+    // деление Бурникеля-Циглера: делитель дополняется нулями снизу до размера block = j * 2^p,
+    // чтобы при рекурсии его можно было делить пополам, пока он не меньше порога,
+    // а делимое режется на блоки такого же размера, старший из которых меньше делителя
+    size_t p = 0;
+    while (((m - 1) >> p) + 1 >= burnikelZieglerThreshold()) {
+        ++p;
+    }
+    size_t block = (((m - 1) >> p) + 1) << p;
+    size_t pad = block - m;
+    size_t blocks = std::max<size_t>((n + pad + 1) / block + 1, 2);
+    std::vector<digit_t> buffer(blocks * block + block + (blocks - 1) * block + 2 * block);
+    digit_t* un = buffer.data();
+    digit_t* vn = un + blocks * block;
+    digit_t* qn = vn + block;
+    digit_t* scratch = qn + (blocks - 1) * block;
+    shiftLeftDigits(vn + pad, v, m, shift);
+    un[pad + n] = shiftLeftDigits(un + pad, u, n, shift);
+
+    for (size_t i = blocks - 1; i > 0; --i) {
+        div2n1n(qn + (i - 1) * block, un + (i - 1) * block, vn, block, scratch);
+    }
+    std::copy_n(qn, n - m + 1, q);
+    if (r != nullptr) {
+        shiftRightDigits(r, un + pad, m, shift);
+    }
+}
+
+// Побитовые ядра: один и тот же цикл для вектора любой ширины (векторные расширения GCC),
+// версии под SSE2, AVX2 и AVX-512 отличаются только атрибутом target.
+// Vector == digit_t -- скалярная версия. a == nullptr -- операция со значением value.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BIGINT_BITWISE_DISPATCH
+#endif
+
+// по ссылкам, чтобы векторы не передавались по значению в функцию без атрибута target
+template <bitwise_op Op, typename T>
+__attribute__((always_inline)) inline void applyBitwise(T& x, T const& y) {
+    x = (Op == bitwise_op::AND ? x & y : Op == bitwise_op::OR ? x | y : Op == bitwise_op::XOR ? x ^ y : y);
+}
+
+template <typename Vector, bitwise_op Op>
+__attribute__((always_inline)) inline void bitwiseLoop(digit_t* r, digit_t const* a, size_t n, digit_t value) {
+    size_t const lanes = sizeof(Vector) / sizeof(digit_t);
+    Vector y = Vector() + value;
+    size_t i = 0;
+    for (; i + lanes <= n; i += lanes) {
+        Vector x;
+        std::memcpy(&x, r + i, sizeof(Vector));
+        if (a != nullptr) {
+            std::memcpy(&y, a + i, sizeof(Vector));
+        }
+        applyBitwise<Op>(x, y);
+        std::memcpy(r + i, &x, sizeof(Vector));
+    }
+    for (; i < n; ++i) {
+        applyBitwise<Op>(r[i], (a == nullptr ? value : a[i]));
+    }
+}
+
+template <typename Vector>
+__attribute__((always_inline)) inline void bitwiseSwitch(digit_t* r, digit_t const* a, size_t n, digit_t value,
+                                                         bitwise_op op) {
+    switch (op) {
+        case bitwise_op::AND:
+            bitwiseLoop<Vector, bitwise_op::AND>(r, a, n, value);
+            break;
+        case bitwise_op::OR:
+            bitwiseLoop<Vector, bitwise_op::OR>(r, a, n, value);
+            break;
+        case bitwise_op::XOR:
+            bitwiseLoop<Vector, bitwise_op::XOR>(r, a, n, value);
+            break;
+        case bitwise_op::ASSIGN:
+            bitwiseLoop<Vector, bitwise_op::ASSIGN>(r, a, n, value);
+            break;
+    }
+}
+
+static void bitwiseScalar(digit_t* r, digit_t const* a, size_t n, digit_t value, bitwise_op op) {
+    bitwiseSwitch<digit_t>(r, a, n, value, op);
+}
+
+#ifdef BIGINT_BITWISE_DISPATCH
+typedef digit_t vector128_t __attribute__((vector_size(16)));
+typedef digit_t vector256_t __attribute__((vector_size(32)));
+typedef digit_t vector512_t __attribute__((vector_size(64)));
+
+__attribute__((target("sse2")))
+static void bitwiseSse2(digit_t* r, digit_t const* a, size_t n, digit_t value, bitwise_op op) {
+    bitwiseSwitch<vector128_t>(r, a, n, value, op);
+}
+
+__attribute__((target("avx2")))
+static void bitwiseAvx2(digit_t* r, digit_t const* a, size_t n, digit_t value, bitwise_op op) {
+    bitwiseSwitch<vector256_t>(r, a, n, value, op);
+}
+
+__attribute__((target("avx512f")))
+static void bitwiseAvx512(digit_t* r, digit_t const* a, size_t n, digit_t value, bitwise_op op) {
+    bitwiseSwitch<vector512_t>(r, a, n, value, op);
+}
+#endif
+
+typedef void (*bitwise_kernel)(digit_t*, digit_t const*, size_t, digit_t, bitwise_op);
+
+static bitwise_kernel selectBitwiseKernel() {
+#ifdef BIGINT_BITWISE_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return bitwiseAvx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return bitwiseAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return bitwiseSse2;
+    }
+#endif
+    return bitwiseScalar;
+}
+
+static void bitwise(digit_t* r, digit_t const* a, size_t n, digit_t value, bitwise_op op) {
+    static bitwise_kernel const kernel = selectBitwiseKernel();
+    if (n != 0) {
+        kernel(r, a, n, value, op);
+    }
+}
+
+void bitwiseVectors(digit_t* r, digit_t const* a, size_t n, bitwise_op op) {
+    bitwise(r, a, n, 0, op);
+}
+
+void bitwiseFill(digit_t* r, size_t n, digit_t value, bitwise_op op) {
+    bitwise(r, nullptr, n, value, op);
+}
@@ -0,0 +1,29 @@
+#ifndef BIGINT_DIGIT_SPAN_H
+#define BIGINT_DIGIT_SPAN_H
+
+#include "digit_type.h"
+
+// Цифры числа одним куском: указатель на младшую и их количество.
+// Остаётся действительным, пока хранилище не меняет размер.
+template <typename T>
+struct basic_digit_span {
+    T* data;
+    size_t size;
+
+    T& operator[](size_t i) const {
+        return data[i];
+    }
+
+    T* begin() const {
+        return data;
+    }
+
+    T* end() const {
+        return data + size;
+    }
+};
+
+typedef basic_digit_span<digit_t> digit_span;
+typedef basic_digit_span<digit_t const> const_digit_span;
+
+#endif //BIGINT_DIGIT_SPAN_H